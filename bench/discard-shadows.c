@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include "herbgrind.h"
+
+#define N 4
+
+int main() {
+  double x = 1e16;
+  double vals[N], results[N];
+  for(int i = 0; i < N; ++i){
+    vals[i] = x + 1;
+  }
+  HERBGRIND_DISCARD_SHADOWS(vals, sizeof(vals));
+  HERBGRIND_PRINT_SHADOW_STATS();
+  for(int i = 0; i < N; ++i){
+    results[i] = vals[i] - x;
+  }
+  for(int i = 0; i < N; ++i){
+    printf("%e\n", results[i]);
+  }
+  return 0;
+}
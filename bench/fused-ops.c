@@ -0,0 +1,16 @@
+#include <stdio.h>
+
+int main() {
+  volatile int flag = 1;
+  double x, e;
+  double results[3];
+  x = 1e16;
+  e = (x + 1) - x;
+  results[0] = (((((((((long double)e + 2) * 3) - 1) * 5) + 4) / 4) - 3) * 6) + 1;
+  results[1] = ((long double)e * 3 + 1) * (flag ? 2 : 3) - 1;
+  results[2] = 6 / ((long double)e + 1) - 2;
+  for(int i = 0; i < 3; ++i){
+    printf("%e\n", results[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <string.h>
+
+#define N 4
+
+double __attribute__ ((noinline)) diff(double a, double b){
+  return a - b;
+}
+
+int main() {
+  volatile size_t size = N * sizeof(double);
+  double x = 1e16;
+  double src[N], dst[N], moved[N + 1], back[N];
+  char bytes[N * sizeof(double) + 3];
+  double results[3 * N + 1];
+  for(int i = 0; i < N; ++i){
+    src[i] = x + 1;
+  }
+  memcpy(dst, src, size);
+  memcpy(moved, src, size);
+  memmove(moved + 1, moved, size);
+  memcpy(bytes + 3, src, size);
+  memcpy(back, bytes + 3, size);
+  for(int i = 0; i < N; ++i){
+    results[i] = diff(dst[i], x);
+    results[N + i] = diff(moved[i + 1], x);
+    results[2 * N + i] = diff(back[i], x);
+  }
+  memset(dst, 0, size);
+  results[3 * N] = dst[0] + 2;
+  for(int i = 0; i < 3 * N + 1; ++i){
+    printf("%e\n", results[i]);
+  }
+  return 0;
+}
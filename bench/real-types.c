@@ -0,0 +1,13 @@
+#include <stdio.h>
+#include <emmintrin.h>
+
+int main() {
+  double x,y;
+  x = 1e16;
+  __m128d v = _mm_set_sd(((x + 1) - x + 1) * 3 / 4);
+  // Use the sqrtsd instruction instead of calling libm, so the sqrt
+  // runs on the shadow reals directly.
+  y = _mm_cvtsd_f64(_mm_sqrt_sd(v, v));
+  printf("%e\n", y);
+  return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 4
+
+double __attribute__ ((noinline)) diff(double a, double b){
+  return a - b;
+}
+
+int main() {
+  double x = 1e16;
+  double results[2 * N];
+  double* xs = malloc(N * sizeof(double));
+  for(int i = 0; i < N; ++i){
+    xs[i] = x + 1;
+  }
+  xs = realloc(xs, 2 * N * sizeof(double));
+  for(int i = 0; i < N; ++i){
+    results[i] = diff(xs[i], x);
+  }
+  free(xs);
+  double* ys = calloc(2 * N, sizeof(double));
+  for(int i = 0; i < N; ++i){
+    results[N + i] = ys[i] + 2;
+  }
+  free(ys);
+  for(int i = 0; i < 2 * N; ++i){
+    printf("%e\n", results[i]);
+  }
+  return 0;
+}
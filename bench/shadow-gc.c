@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 100000
+
+int main() {
+  double x = 1e16;
+  double* vals = malloc(N * sizeof(double));
+  for(int i = 0; i < N; ++i){
+    vals[i] = (x + 1) - x;
+  }
+  double total = 0;
+  for(int i = 0; i < N; ++i){
+    total = total + vals[i];
+  }
+  free(vals);
+  printf("%e\n", total);
+  return 0;
+}
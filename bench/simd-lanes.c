@@ -0,0 +1,20 @@
+#include <stdio.h>
+
+typedef double v2df __attribute__ ((vector_size (16)));
+typedef float v4sf __attribute__ ((vector_size (16)));
+
+int main() {
+  volatile double x = 1e16;
+  v2df big = {x, x};
+  v2df ones = {1, 1};
+  v2df sums = (big + ones) - big + ones;
+  v2df scaled = sums * (v2df){3, 0};
+  v4sf fsums = {sums[0], sums[1], sums[0], sums[1]};
+  v4sf fscaled = fsums * (v4sf){3, 0, 5, 0};
+  double results[6] = {scaled[0], scaled[1],
+                       fscaled[0], fscaled[1], fscaled[2], fscaled[3]};
+  for(int i = 0; i < 6; ++i){
+    printf("%e\n", results[i]);
+  }
+  return 0;
+}
@@ -10,9 +10,9 @@ def compare_results(actual, expected):
     return HEX_RE.sub("<addr>", LINE_RE.sub("<linenum>", actual)) == \
         HEX_RE.sub("<addr>", LINE_RE.sub("<linenum>", expected))
 
-def test(prog):
+def test(prog, flags=[]):
     command = ["./valgrind/herbgrind-install/bin/valgrind", "--tool=herbgrind",
-               "--output-sexp", prog]
+               "--output-sexp"] + flags + [prog]
     print("Calling `{}`...".format(" ".join(command)), end=" ")
     proc = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
     stdout, stderr = proc.communicate()
@@ -63,7 +63,18 @@ def test(prog):
     print("Outputs match.")
     return True
 
+# A test can also be run with other sets of herbgrind flags, one set
+# per line of bench/foo.c.args, and each run has to match the same
+# expected output.
+def extra_flags(prog):
+    try:
+        with open(prog[:-len(".out")] + ".args") as args_file:
+            return [line.split() for line in args_file if line.strip()]
+    except FileNotFoundError:
+        return []
+
 if __name__ == "__main__":
     for arg in sys.argv[1:]:
-        if not test(arg):
-            sys.exit(1)
+        for flags in [[]] + extra_flags(arg):
+            if not test(arg, flags):
+                sys.exit(1)
@@ -0,0 +1,124 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie              memwrap.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "pub_tool_clreq.h"
+#include "pub_tool_redir.h"
+
+#include <stddef.h>
+
+#include "../include/herbgrind.h"
+
+// Redirect the client's block memory functions into the tool, which
+// moves the bytes and their shadow values in one go. Otherwise, a
+// copy of an array of doubles shows up as a long string of integer
+// and vector loads and stores, which is slow to shadow, and drops
+// the shadow values whenever the copy goes through a non-float
+// type. If the tool refuses (because the memory isn't accessible),
+// we do the work here so the client faults like it normally would.
+
+static void* wrappedMemmove(void* dest, const void* src, size_t len){
+  if (!HERBGRIND_MEMMOVE(dest, src, len)){
+    unsigned char* d = dest;
+    const unsigned char* s = src;
+    if (d < s){
+      for(size_t i = 0; i < len; ++i){
+        d[i] = s[i];
+      }
+    } else {
+      for(size_t i = len; i > 0; --i){
+        d[i - 1] = s[i - 1];
+      }
+    }
+  }
+  return dest;
+}
+// The fortified versions abort in glibc if the copy would run off
+// the end of the destination, so we do the same thing here, the way
+// memcheck does.
+extern void _exit(int status);
+static void chkFail(const char* fnname){
+  VALGRIND_PRINTF_BACKTRACE("*** %s: buffer overflow detected ***: "
+                            "program terminated\n", fnname);
+  _exit(127);
+}
+static void* wrappedMemset(void* dest, int c, size_t len){
+  if (!HERBGRIND_MEMSET(dest, c, len)){
+    unsigned char* d = dest;
+    for(size_t i = 0; i < len; ++i){
+      d[i] = (unsigned char)c;
+    }
+  }
+  return dest;
+}
+
+#define WRAP_MEMMOVE(soname, fnname)                                    \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, const void* src, size_t len);                          \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, const void* src, size_t len){                          \
+    return wrappedMemmove(dest, src, len);                              \
+  }
+#define WRAP_MEMMOVE_CHK(soname, fnname, chkname)                      \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, const void* src, size_t len, size_t destlen);          \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, const void* src, size_t len, size_t destlen){          \
+    if (destlen < len){                                                 \
+      chkFail(chkname);                                                 \
+    }                                                                   \
+    return wrappedMemmove(dest, src, len);                              \
+  }
+#define WRAP_MEMSET(soname, fnname)                                     \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, int c, size_t len);                                    \
+  void* VG_REPLACE_FUNCTION_ZU(soname, fnname)                         \
+    (void* dest, int c, size_t len){                                    \
+    return wrappedMemset(dest, c, len);                                 \
+  }
+#define WRAP_BZERO(soname, fnname)                                      \
+  void VG_REPLACE_FUNCTION_ZU(soname, fnname)(void* dest, size_t len);  \
+  void VG_REPLACE_FUNCTION_ZU(soname, fnname)(void* dest, size_t len){  \
+    wrappedMemset(dest, 0, len);                                        \
+  }
+// memcpy is allowed to assume its arguments don't overlap, but it
+// doesn't hurt to handle it anyway.
+WRAP_MEMMOVE(VG_Z_LIBC_SONAME, memcpy)
+WRAP_MEMMOVE(VG_Z_LIBC_SONAME, memcpyZAGLIBCZu2Zd2Zd5)
+WRAP_MEMMOVE(VG_Z_LIBC_SONAME, memcpyZAZAGLIBCZu2Zd14)
+WRAP_MEMMOVE(VG_Z_LIBC_SONAME, memmove)
+WRAP_MEMMOVE_CHK(VG_Z_LIBC_SONAME, __memcpy_chk, "memcpy_chk")
+WRAP_MEMMOVE_CHK(VG_Z_LIBC_SONAME, __memmove_chk, "memmove_chk")
+WRAP_MEMSET(VG_Z_LIBC_SONAME, memset)
+WRAP_BZERO(VG_Z_LIBC_SONAME, bzero)
+
+// For statically linked programs.
+WRAP_MEMMOVE(NONE, memcpy)
+WRAP_MEMMOVE(NONE, memmove)
+WRAP_MEMSET(NONE, memset)
+WRAP_BZERO(NONE, bzero)
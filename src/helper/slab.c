@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie                 slab.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "slab.h"
+
+#include "pub_tool_mallocfree.h"
+#include "pub_tool_libcassert.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_libcprint.h"
+
+SlabClass slabClasses[NUM_SLAB_CLASSES];
+static ULong numBigAllocs = 0;
+
+void* slabAlloc(SizeT size){
+  if (size > MAX_SLAB_SIZE){
+    numBigAllocs++;
+    return VG_(malloc)("slab big object", size);
+  }
+  return slabAlloc_fast(size);
+}
+void slabFree(void* obj, SizeT size){
+  if (size > MAX_SLAB_SIZE){
+    VG_(free)(obj);
+    return;
+  }
+  slabFree_fast(obj, size);
+}
+// Called when a class has nothing on its free list. Takes the next
+// object out of the current chunk, getting a new chunk if we've used
+// this one up.
+void* slabAllocFromChunk(SlabClass* class){
+  if (class->objSize == 0){
+    class->objSize = ((class - slabClasses) + 1) * SLAB_GRANULE;
+  }
+  if (class->chunkNext + class->objSize > class->chunkEnd){
+    SizeT chunkBytes = SLAB_CHUNK_BYTES;
+    if (chunkBytes < class->objSize * 16){
+      chunkBytes = class->objSize * 16;
+    }
+    // Chunks are never given back, so there's no need to remember
+    // where the unaligned start was.
+    char* chunk = VG_(malloc)("slab chunk", chunkBytes + SLAB_CHUNK_ALIGN);
+    class->chunkNext = (char*)VG_ROUNDUP(chunk, SLAB_CHUNK_ALIGN);
+    class->chunkEnd = class->chunkNext + chunkBytes;
+    class->numChunks++;
+    class->chunkBytes += chunkBytes;
+  }
+  void* result = class->chunkNext;
+  class->chunkNext += class->objSize;
+  if (class->numLive > class->peakLive){
+    class->peakLive = class->numLive;
+  }
+  return result;
+}
+void slabGrowFreeList(SlabClass* class){
+  if (class->freeCapacity == 0){
+    class->freeCapacity = 64;
+  } else {
+    class->freeCapacity *= 2;
+  }
+  class->freeObjs = VG_(realloc)("slab free list", class->freeObjs,
+                                 class->freeCapacity * sizeof(void*));
+}
+
+void printSlabStats(void){
+  VG_(printf)("  slab classes (size: live/peak, free, chunks, allocs):\n");
+  SizeT totalBytes = 0;
+  for(int i = 0; i < NUM_SLAB_CLASSES; ++i){
+    SlabClass* class = &(slabClasses[i]);
+    if (class->numChunks == 0) continue;
+    VG_(printf)("    %lu: %lu/%lu, %lu, %lu, %llu\n",
+                class->objSize, class->numLive, class->peakLive,
+                class->numFree, class->numChunks, class->numAllocs);
+    totalBytes += class->chunkBytes;
+  }
+  VG_(printf)("  %lu bytes in slab chunks, %llu objects too big for a slab\n",
+              totalBytes, numBigAllocs);
+}
+// For classes that aren't in slabClasses.
+void printSlabClassStats(const char* name, SlabClass* class){
+  VG_(printf)("  %s (%lu bytes): %lu/%lu, %lu, %lu, %llu\n",
+              name, class->objSize, class->numLive, class->peakLive,
+              class->numFree, class->numChunks, class->numAllocs);
+}
@@ -0,0 +1,123 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie                 slab.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include "pub_tool_basics.h"
+
+// Size-classed slab arenas for the small objects we make and throw
+// away constantly: shadow values, temps, expressions, and the like.
+// Each class hands out objects of one size, carved out of big chunks,
+// and keeps the objects given back to it in a dense array, so
+// reusing one doesn't have to chase pointers through freed memory.
+//
+// Sizes are rounded up to SLAB_GRANULE bytes, and every object of a
+// size that's a multiple of SLAB_CHUNK_ALIGN starts on a cache line.
+// Anything bigger than MAX_SLAB_SIZE just goes to VG_(malloc).
+#define SLAB_GRANULE 16
+#define SLAB_CHUNK_ALIGN 64
+#define MAX_SLAB_SIZE 4096
+#define NUM_SLAB_CLASSES (MAX_SLAB_SIZE / SLAB_GRANULE)
+#define SLAB_CHUNK_BYTES (64 * 1024)
+
+typedef struct _SlabClass {
+  SizeT objSize;
+  // The rest of the current chunk, which we haven't handed out yet.
+  char* chunkNext;
+  char* chunkEnd;
+  // Objects that have been given back.
+  void** freeObjs;
+  SizeT numFree;
+  SizeT freeCapacity;
+  // For reporting.
+  SizeT numChunks;
+  SizeT chunkBytes;
+  SizeT numLive;
+  SizeT peakLive;
+  ULong numAllocs;
+} SlabClass;
+
+extern SlabClass slabClasses[NUM_SLAB_CLASSES];
+
+// A class can also stand on its own, outside of slabClasses, for
+// objects that are hot enough that we want them packed together
+// instead of mixed in with everything else of their size.
+#define SLAB_CLASS_INIT(size) {.objSize = VG_ROUNDUP(size, SLAB_GRANULE)}
+
+void* slabAlloc(SizeT size);
+void slabFree(void* obj, SizeT size);
+void printSlabStats(void);
+void printSlabClassStats(const char* name, SlabClass* class);
+
+// Slow paths for the inline versions below.
+void* slabAllocFromChunk(SlabClass* class);
+void slabGrowFreeList(SlabClass* class);
+
+inline void* slabClassAlloc_fast(SlabClass* class);
+inline void slabClassFree_fast(SlabClass* class, void* obj);
+inline void* slabAlloc_fast(SizeT size);
+inline void slabFree_fast(void* obj, SizeT size);
+
+__attribute__((always_inline))
+inline
+void* slabAlloc_fast(SizeT size){
+  if (size > MAX_SLAB_SIZE) return slabAlloc(size);
+  return slabClassAlloc_fast(&(slabClasses[(size - 1) / SLAB_GRANULE]));
+}
+__attribute__((always_inline))
+inline
+void slabFree_fast(void* obj, SizeT size){
+  if (size > MAX_SLAB_SIZE){
+    slabFree(obj, size);
+    return;
+  }
+  slabClassFree_fast(&(slabClasses[(size - 1) / SLAB_GRANULE]), obj);
+}
+__attribute__((always_inline))
+inline
+void* slabClassAlloc_fast(SlabClass* class){
+  class->numLive++;
+  class->numAllocs++;
+  if (class->numFree > 0){
+    return class->freeObjs[--(class->numFree)];
+  }
+  return slabAllocFromChunk(class);
+}
+__attribute__((always_inline))
+inline
+void slabClassFree_fast(SlabClass* class, void* obj){
+  if (class->numFree == class->freeCapacity){
+    slabGrowFreeList(class);
+  }
+  class->freeObjs[class->numFree++] = obj;
+  class->numLive--;
+}
+
+#endif
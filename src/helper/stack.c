@@ -57,6 +57,13 @@ StackNode* stack_pop(Stack* s){
 int stack_empty(Stack* s){
   return (s->head == NULL);
 }
+SizeT stack_size(Stack* s){
+  SizeT size = 0;
+  for(StackNode* node = s->head; node != NULL; node = node->next){
+    size++;
+  }
+  return size;
+}
 void addStackPushG(IRSB* sbOut, IRExpr* guard, Stack* s, IRExpr* node){
   IRExpr* sHead = runLoad64C(sbOut, &(s->head));
   addStoreArrowG(sbOut, guard, node, StackNode,
@@ -53,6 +53,8 @@ void stack_push(Stack* s, StackNode* item);
 VG_REGPARM(2) void stack_push2(Stack* s, StackNode* item_node);
 StackNode* stack_pop(Stack* s);
 int stack_empty(Stack* s);
+// Walks the whole stack, so only use this for reporting.
+SizeT stack_size(Stack* s);
 
 void addStackPushG(IRSB* sbOut, IRExpr* guard, Stack* s, IRExpr* node);
 void addStackPush(IRSB* sbOut, Stack* s, IRExpr* node);
@@ -33,9 +33,12 @@
 #include "options.h"
 #include "instrument/instrument.h"
 #include "runtime/shadowop/mathreplace.h"
+#include "runtime/shadowop/shadowop.h"
 #include "runtime/shadowop/influence-op.h"
 #include "runtime/op-shadowstate/marks.h"
 #include "runtime/op-shadowstate/output.h"
+#include "runtime/wrap/malloc-replace.h"
+#include "runtime/wrap/mem-intercept.h"
 
 #include "helper/mpfr-valgrind-glue.h"
 
@@ -85,6 +88,18 @@ static Bool hg_handle_client_request(ThreadId tid, UWord* arg, UWord* ret) {
   case VG_USERREQ__FORCE_TRACK:
     forceTrack((Addr)arg[1]);
     break;
+  case VG_USERREQ__MEMMOVE:
+    *ret = interceptMemmove((Addr)arg[1], (Addr)arg[2], (SizeT)arg[3]);
+    return True;
+  case VG_USERREQ__MEMSET:
+    *ret = interceptMemset((Addr)arg[1], (Int)arg[2], (SizeT)arg[3]);
+    return True;
+  case VG_USERREQ__DISCARD_SHADOWS:
+    discardMemShadowRange((Addr)arg[1], (SizeT)arg[2]);
+    break;
+  case VG_USERREQ__PRINT_SHADOW_STATS:
+    printShadowMemStats();
+    break;
   default:
     return False;
   }
@@ -95,7 +110,17 @@ static Bool hg_handle_client_request(ThreadId tid, UWord* arg, UWord* ret) {
 // This is called after the program exits, for cleanup and such.
 static void hg_fini(Int exitcode){
   finish_instrumentation();
+  flushDeferredFrees();
   writeOutput();
+  if (print_shadow_stats){
+    printShadowMemStats();
+    VG_(printf)("Skipped the shadow computation for %llu exact ops.\n",
+                numExactShadowOps);
+    if (adaptivePrecision()){
+      VG_(printf)("Raised the precision of an op %llu times.\n",
+                  numPrecisionEscalations);
+    }
+  }
 }
 // This does any initialization that needs to be done after command
 // line processing.
@@ -122,6 +147,25 @@ static void hg_pre_clo_init(void)
    VG_(needs_command_line_options)(hg_process_cmd_line_option,
                                    hg_print_usage,
                                    hg_print_debug_usage);
+   VG_(needs_malloc_replacement)(hg_malloc,
+                                 hg_builtin_new,
+                                 hg_builtin_vec_new,
+                                 hg_memalign,
+                                 hg_calloc,
+                                 hg_free,
+                                 hg_builtin_delete,
+                                 hg_builtin_vec_delete,
+                                 hg_realloc,
+                                 hg_malloc_usable_size,
+                                 0);
+   initMallocReplacement();
+   VG_(track_die_mem_stack)(dieMemStack);
+   VG_(track_die_mem_stack_signal)(dieMemStack);
+   VG_(track_new_mem_stack)(newMemStack);
+
+   VG_(track_pre_thread_ll_create)(shadowThreadCreate);
+   VG_(track_pre_thread_ll_exit)(shadowThreadExit);
+   VG_(track_start_client_code)(shadowThreadRun);
    setup_mpfr_valgrind_glue();
 }
 
@@ -49,6 +49,10 @@ typedef enum {
   VG_USERREQ__MARK_IMPORTANT,
   VG_USERREQ__MAYBE_MARK_IMPORTANT,
   VG_USERREQ__MAYBE_MARK_IMPORTANT_WITH_INDEX,
+  VG_USERREQ__MEMMOVE,
+  VG_USERREQ__MEMSET,
+  VG_USERREQ__DISCARD_SHADOWS,
+  VG_USERREQ__PRINT_SHADOW_STATS,
 } Vg_HerbgrindClientRequests;
 
 typedef enum {
@@ -149,4 +153,42 @@ typedef enum {
                                  &(_qzz_var), argIdx, nargs, 0, 0);      \
       _qzz_res;                                                 \
     }))
+// These return zero if the tool didn't do the copy (or set), either
+// because we're not running under herbgrind or because the memory
+// isn't accessible.
+#define HERBGRIND_MEMMOVE(_qzz_dest, _qzz_src, _qzz_len)        \
+  (__extension__({unsigned long _qzz_res;                       \
+      VALGRIND_DO_CLIENT_REQUEST(_qzz_res, 0,                   \
+                                 VG_USERREQ__MEMMOVE,           \
+                                 _qzz_dest, _qzz_src, _qzz_len, \
+                                 0, 0);                         \
+      _qzz_res;                                                 \
+    }))
+#define HERBGRIND_MEMSET(_qzz_dest, _qzz_c, _qzz_len)           \
+  (__extension__({unsigned long _qzz_res;                       \
+      VALGRIND_DO_CLIENT_REQUEST(_qzz_res, 0,                   \
+                                 VG_USERREQ__MEMSET,            \
+                                 _qzz_dest, _qzz_c, _qzz_len,   \
+                                 0, 0);                         \
+      _qzz_res;                                                 \
+    }))
+// Forget the shadow values for everything in [ptr, ptr + len), so
+// that it's treated like it was never touched by a float op. Useful
+// for big scratch buffers that are about to be reinitialized.
+#define HERBGRIND_DISCARD_SHADOWS(_qzz_ptr, _qzz_len)           \
+  (__extension__({unsigned long _qzz_res;                       \
+      VALGRIND_DO_CLIENT_REQUEST(_qzz_res, 0,                   \
+                                 VG_USERREQ__DISCARD_SHADOWS,   \
+                                 _qzz_ptr, _qzz_len, 0, 0, 0);  \
+      _qzz_res;                                                 \
+    }))
+// Print how much shadow memory is in use, and how it's laid out. The
+// lookup counts are only kept with --print-shadow-stats.
+#define HERBGRIND_PRINT_SHADOW_STATS()                          \
+  (__extension__({unsigned long _qzz_res;                       \
+      VALGRIND_DO_CLIENT_REQUEST(_qzz_res, 0,                   \
+                                 VG_USERREQ__PRINT_SHADOW_STATS, \
+                                 0, 0, 0, 0, 0);                \
+      _qzz_res;                                                 \
+    }))
 #endif
@@ -48,15 +48,13 @@
 #include "../helper/debug.h"
 #include "../options.h"
 
-void instrumentOp(IRSB* sbOut, IRTemp dest, IRExpr* expr,
-                  Addr curAddr, Addr blockAddr,
-                  int instrIdx){
-  // Get the IROp value, the number of args, and the argument
-  // expressions out of the structure based on whether it's a Unop, a
-  // Binop, or a Triop.
+// Get the IROp value, the number of args, and the argument
+// expressions out of the structure based on whether it's a Unop, a
+// Binop, a Triop, or a Qop.
+void getOpArgs(IRExpr* expr, IROp* op_code_out, int* nargs_out,
+               IRExpr** argExprs){
   IROp op_code;
   int nargs;
-  IRExpr* argExprs[4];
   switch(expr->tag){
   case Iex_Unop:
     op_code = expr->Iex.Unop.op;
@@ -102,6 +100,21 @@ void instrumentOp(IRSB* sbOut, IRTemp dest, IRExpr* expr,
     tl_assert(0);
     return;
   }
+  *op_code_out = op_code;
+  *nargs_out = nargs;
+}
+// Whether an op goes through instrumentSemanticOp.
+Bool isSemanticOp(IROp op_code){
+  return !isSpecialOp(op_code) && !isExitFloatOp(op_code) &&
+    isFloatOp(op_code) && !isConversionOp(op_code);
+}
+void instrumentOp(IRSB* sbOut, IRTemp dest, IRExpr* expr,
+                  Addr curAddr, Addr blockAddr,
+                  int instrIdx){
+  IROp op_code;
+  int nargs;
+  IRExpr* argExprs[4];
+  getOpArgs(expr, &op_code, &nargs, argExprs);
   // If the op isn't a float op, dont shadow it.
   if (isSpecialOp(op_code)){
     handleSpecialOp(sbOut, op_code, argExprs, dest,
@@ -33,6 +33,9 @@
 #include "pub_tool_tooliface.h"
 #include "../runtime/value-shadowstate/shadowval.h"
 
+void getOpArgs(IRExpr* expr, IROp* op_code_out, int* nargs_out,
+               IRExpr** argExprs);
+Bool isSemanticOp(IROp op_code);
 void instrumentOp(IRSB* sbOut, IRTemp dest, IRExpr* expr,
                   Addr curAddr, Addr blockAddr,
                   int instrIdx);
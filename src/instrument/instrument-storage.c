@@ -662,10 +662,19 @@ IRExpr* runMakeInputG(IRSB* sbOut, IRExpr* guard, IRExpr* argExpr,
 IRExpr* runLoadTemp(IRSB* sbOut, int idx){
   return runLoad64C(sbOut, &(shadowTemps[idx]));
 }
+// Translations are shared between threads, so we can't bake the
+// thread state address in; instead, look up the running thread's
+// array when the block runs.
+IRExpr* runTSValAddr(IRSB* sbOut, IRExpr* tsIdx){
+  return runBinop(sbOut, Iop_Add64,
+                  runLoad64C(sbOut, &curThreadState),
+                  runBinop(sbOut, Iop_Mul64,
+                           tsIdx,
+                           mkU64(sizeof(ShadowValue*))));
+}
 IRExpr* runGetTSVal(IRSB* sbOut, Int tsSrc, int instrIdx){
   tl_assert(tsAddrCanBeShadowed(tsSrc, instrIdx));
-  IRExpr* val = runLoad64C(sbOut,
-                           &(shadowThreadState[VG_(get_running_tid)()][tsSrc]));
+  IRExpr* val = runLoad64(sbOut, runTSValAddr(sbOut, mkU64(tsSrc)));
   /* if (PRINT_VALUE_MOVES){ */
   /*   if (tsHasStaticShadow(tsSrc, instrIdx)){ */
   /*     addPrint3("Getting val %p from TS(%d) -> ", val, mkU64(tsSrc)); */
@@ -677,12 +686,7 @@ IRExpr* runGetTSVal(IRSB* sbOut, Int tsSrc, int instrIdx){
   return val;
 }
 IRExpr* runGetTSValDynamic(IRSB* sbOut, IRExpr* tsSrc){
-  return runLoad64(sbOut,
-                   runBinop(sbOut,
-                            Iop_Add64,
-                            mkU64((uintptr_t)shadowThreadState
-                                  [VG_(get_running_tid)()]),
-                            tsSrc));
+  return runLoad64(sbOut, runTSValAddr(sbOut, tsSrc));
 }
 void addSetTSValNonNull(IRSB* sbOut, Int tsDest,
                         IRExpr* newVal,
@@ -720,9 +724,7 @@ void addSetTSVal(IRSB* sbOut, Int tsDest, IRExpr* newVal, int instrIdx){
                "addSetTSVal: Setting thread state TS(%d) to %p\n",
                mkU64(tsDest), newVal);
   }
-  addStoreC(sbOut,
-            newVal,
-            &(shadowThreadState[VG_(get_running_tid)()][tsDest]));
+  addStore(sbOut, newVal, runTSValAddr(sbOut, mkU64(tsDest)));
 }
 void addSetTSValDynamic(IRSB* sbOut, IRExpr* tsDest, IRExpr* newVal, int instrIdx){
   if (PRINT_VALUE_MOVES){
@@ -734,15 +736,7 @@ void addSetTSValDynamic(IRSB* sbOut, IRExpr* tsDest, IRExpr* newVal, int instrId
                "addSetTSValDynamic: Setting thread state %d to %p\n",
                tsDest, newVal);
   }
-  addStore(sbOut, newVal,
-           runBinop(sbOut,
-                    Iop_Add64,
-                    mkU64((uintptr_t)shadowThreadState
-                          [VG_(get_running_tid)()]),
-                    runBinop(sbOut,
-                             Iop_Mul64,
-                             tsDest,
-                             mkU64(sizeof(ShadowValue*)))));
+  addStore(sbOut, newVal, runTSValAddr(sbOut, tsDest));
 }
 void addStoreTemp(IRSB* sbOut, IRExpr* shadow_temp,
                   int idx){
@@ -773,130 +767,141 @@ void addStoreTempUnknown(IRSB* sbOut, IRExpr* shadow_temp_maybe,
                          int idx){
   addStoreTemp(sbOut, shadow_temp_maybe, idx);
 }
-IRExpr* getBucketAddr(IRSB* sbOut, IRExpr* memAddr){
-  IRExpr* bucket = runMod(sbOut, memAddr, mkU32(LARGE_PRIME));
+// Check the page bitmap to see whether anything near memAddr might
+// be shadowed. For memory that's never held a shadowed float, this
+// is the only load we do.
+IRExpr* runMaybeShadowed(IRSB* sbOut, IRExpr* memAddr){
+  IRExpr* page =
+    runBinop(sbOut, Iop_And64,
+             runBinop(sbOut, Iop_Shr64, memAddr, mkU8(SHADOW_PAGE_BITS)),
+             mkU64(N_SHADOW_PAGES - 1));
+  IRExpr* bitmapWord =
+    runLoad64(sbOut,
+              runBinop(sbOut, Iop_Add64,
+                       mkU64((uintptr_t)shadowPageBitmap),
+                       runBinop(sbOut, Iop_Mul64,
+                                runBinop(sbOut, Iop_Shr64, page, mkU8(6)),
+                                mkU64(sizeof(UWord)))));
+  IRExpr* pageBit =
+    runBinop(sbOut, Iop_And64,
+             runBinop(sbOut, Iop_Shr64, bitmapWord,
+                      runUnop(sbOut, Iop_64to8,
+                              runBinop(sbOut, Iop_And64,
+                                       page, mkU64(63)))),
+             mkU64(1));
+  // Addresses past the primary map aren't covered by the bitmap, so
+  // for those, check whether there's anything in the auxiliary table.
+  IRExpr* pastPrimary =
+    runBinop(sbOut, Iop_CmpLT64U, mkU64(MAX_PRIMARY_ADDRESS), memAddr);
+  IRExpr* auxNonEmpty =
+    runNonZeroCheck64(sbOut,
+                      runLoadG64C(sbOut, &numAuxMemEntries, pastPrimary));
+  return runOr(sbOut,
+               runNonZeroCheck64(sbOut, pageBit),
+               runAnd(sbOut, pastPrimary, auxNonEmpty));
+}
+// Compute the address of the shadow slot for the eight-byte unit
+// containing memAddr. Since we mask the primary index, this is always
+// safe to load from, but for addresses which live in the auxiliary
+// table instead (see inPrimaryMap), what you find there is
+// meaningless.
+IRExpr* getBucketAddrG(IRSB* sbOut, IRExpr* guard, IRExpr* memAddr){
+  IRExpr* primaryIdx =
+    runBinop(sbOut, Iop_And64,
+             runBinop(sbOut, Iop_Shr64, memAddr, mkU8(SM_BITS)),
+             mkU64(N_PRIMARY_MAP - 1));
+  IRExpr* secondaryMap =
+    runLoadG64(sbOut,
+               runBinop(sbOut, Iop_Add64,
+                        mkU64((uintptr_t)primaryMap),
+                        runBinop(sbOut, Iop_Mul64,
+                                 primaryIdx,
+                                 mkU64(sizeof(SecondaryMap*)))),
+               guard);
+  IRExpr* secondaryIdx =
+    runBinop(sbOut, Iop_Shr64,
+             runBinop(sbOut, Iop_And64, memAddr, mkU64(SM_MASK)),
+             mkU8(3));
   return runBinop(sbOut, Iop_Add64,
-                  mkU64((uintptr_t)shadowMemTable),
+                  secondaryMap,
                   runBinop(sbOut, Iop_Mul64,
-                           bucket,
-                           mkU64(sizeof(TableValueEntry*))));
+                           secondaryIdx,
+                           mkU64(sizeof(UWord))));
 }
 
-QuickBucketResult quickGetBucket(IRSB* sbOut, IRExpr* memAddr){
-  QuickBucketResult result;
-  IRExpr* bucketEntry =
-    runLoad64(sbOut, getBucketAddr(sbOut, memAddr));
-  IRExpr* entryExists =
-    runNonZeroCheck64(sbOut, bucketEntry);
-  IRExpr* entryAddr =
-    runArrowG(sbOut, entryExists, bucketEntry,
-              TableValueEntry, addr);
-  IRExpr* entryNext =
-    runArrowG(sbOut, entryExists, bucketEntry,
-              TableValueEntry, next);
-  IRExpr* addrMatches =
-    runBinop(sbOut, Iop_CmpEQ64, entryAddr, memAddr);
-  IRExpr* moreChain = runNonZeroCheck64(sbOut, entryNext);
-  result.entry =
-    runArrowG(sbOut, addrMatches, bucketEntry, TableValueEntry, val);
-  result.stillSearching32 =
-    runBinop(sbOut, Iop_And32,
-             runUnop(sbOut, Iop_1Uto32, moreChain),
-             runUnop(sbOut, Iop_Not32,
-                     runUnop(sbOut, Iop_1Uto32, addrMatches)));
-  return result;
+// Figure out whether there might be any shadow values in the size
+// blocks at memAddr, in which case we have to go to C to deal with
+// them. We check the page bitmap for the first and last byte (no
+// access is big enough to span more than two pages), and if either
+// is set, we look at the slot for each eight-byte unit the access
+// touches. Addresses that belong in the auxiliary table always go to
+// C if their page might be shadowed.
+IRExpr* runMemMaybeShadowedG(IRSB* sbOut, IRExpr* guard,
+                             FloatBlocks size, IRExpr* memAddr){
+  IRExpr* lastBlockAddr =
+    runBinop(sbOut, Iop_Add64, memAddr,
+             mkU64((INT(size) - 1) * sizeof(float)));
+  IRExpr* pageMaybeShadowed = runMaybeShadowed(sbOut, memAddr);
+  if (INT(size) > 1){
+    pageMaybeShadowed =
+      runOr(sbOut, pageMaybeShadowed,
+            runMaybeShadowed(sbOut,
+                             runBinop(sbOut, Iop_Add64, lastBlockAddr,
+                                      mkU64(sizeof(float) - 1))));
+  }
+  IRExpr* maybeShadowed = runAnd(sbOut, guard, pageMaybeShadowed);
+
+  IRExpr* notInPrimary =
+    runNonZeroCheck64(sbOut,
+                      runBinop(sbOut, Iop_And64,
+                               runBinop(sbOut, Iop_Or64,
+                                        memAddr, lastBlockAddr),
+                               mkU64(AUX_ADDR_MASK)));
+  IRExpr* goToC = runAnd(sbOut, maybeShadowed, notInPrimary);
+
+  // If the access starts halfway through a unit, it'll spill over
+  // into one more unit than it would otherwise.
+  int numUnits = (INT(size) + 1) / 2;
+  IRExpr* unalignedDouble =
+    runNonZeroCheck64(sbOut,
+                      runBinop(sbOut, Iop_And64,
+                               memAddr, mkU64(sizeof(double) - 1)));
+  for(int i = 0; i < numUnits + (INT(size) % 2 == 0 ? 1 : 0); ++i){
+    IRExpr* unitGuard = maybeShadowed;
+    if (i == numUnits){
+      unitGuard = runAnd(sbOut, maybeShadowed, unalignedDouble);
+    }
+    IRExpr* slot =
+      runLoadG64(sbOut,
+                 getBucketAddrG(sbOut, unitGuard,
+                                runBinop(sbOut, Iop_Add64, memAddr,
+                                         mkU64(i * sizeof(double)))),
+                 unitGuard);
+    goToC = runOr(sbOut, goToC, runNonZeroCheck64(sbOut, slot));
+  }
+  if (print_shadow_stats){
+    addCountG(sbOut, &numInlineMemChecks, guard);
+    addCountG(sbOut, &numInlineMemChecksToC, goToC);
+  }
+  return goToC;
 }
-QuickBucketResult quickGetBucketG(IRSB* sbOut, IRExpr* guard,
-                                  IRExpr* memAddr){
-  QuickBucketResult result;
-  IRExpr* bucketEntry =
-    runLoadG64(sbOut, getBucketAddr(sbOut, memAddr), guard);
-  IRExpr* entryExists = runNonZeroCheck64(sbOut, bucketEntry);
-  IRExpr* shouldDoAnything = runAnd(sbOut, entryExists, guard);
-  IRExpr* entryAddr =
-    runArrowG(sbOut, shouldDoAnything, bucketEntry,
-              TableValueEntry, addr);
-  IRExpr* entryNext =
-    runArrowG(sbOut, shouldDoAnything, bucketEntry,
-              TableValueEntry, next);
-  IRExpr* addrMatches =
-    runBinop(sbOut, Iop_CmpEQ64, entryAddr, memAddr);
-  IRExpr* moreChain = runNonZeroCheck64(sbOut, entryNext);
-  result.entry =
-    runArrowG(sbOut, addrMatches, bucketEntry, TableValueEntry, val);
-  result.stillSearching32 =
-    runBinop(sbOut, Iop_And32,
-             runUnop(sbOut, Iop_1Uto32, moreChain),
-             runUnop(sbOut, Iop_Not32,
-                     runUnop(sbOut, Iop_1Uto32, addrMatches)));
-  return result;
+// Add one to a counter if cond is true.
+void addCountG(IRSB* sbOut, ULong* counter, IRExpr* cond){
+  addStoreC(sbOut,
+            runBinop(sbOut, Iop_Add64,
+                     runLoad64C(sbOut, counter),
+                     runUnop(sbOut, Iop_1Uto64, cond)),
+            counter);
 }
 IRExpr* runGetMemUnknownG(IRSB* sbOut, IRExpr* guard,
                           FloatBlocks size, IRExpr* memSrc){
-  QuickBucketResult qresults[MAX_TEMP_BLOCKS];
-  IRExpr* anyNonTrivialChains_32 = mkU32(0);
-  IRExpr* allNull_32 = mkU32(1);
-  for(int i = 0; i < INT(size); ++i){
-    qresults[i] = quickGetBucketG(sbOut, guard,
-                                  runBinop(sbOut, Iop_Add64, memSrc,
-                                           mkU64(i * sizeof(float))));
-    anyNonTrivialChains_32 =
-      runBinop(sbOut, Iop_Or32,
-               anyNonTrivialChains_32,
-               qresults[i].stillSearching32);
-    IRExpr* entryNull = runZeroCheck64(sbOut, qresults[i].entry);
-    allNull_32 = runBinop(sbOut, Iop_And32,
-                          allNull_32,
-                          runUnop(sbOut, Iop_1Uto32,
-                                  entryNull));
-  }
-  IRExpr* goToC = runOr(sbOut,
-                        runUnop(sbOut, Iop_32to1, anyNonTrivialChains_32),
-                        runUnop(sbOut, Iop_Not1,
-                                runUnop(sbOut, Iop_32to1,
-                                        allNull_32)));
+  IRExpr* goToC = runMemMaybeShadowedG(sbOut, guard, size, memSrc);
   return runITE(sbOut, goToC,
                 runGetMemG(sbOut, goToC, size, memSrc),
                 mkU64(0));
 }
 IRExpr* runGetMemUnknown(IRSB* sbOut, FloatBlocks size, IRExpr* memSrc){
-  IRExpr* anyNonTrivialChains_32 = NULL;
-  IRExpr* allNull_32 = NULL;
-  if (INT(size) == 1){
-    QuickBucketResult qresult =
-      quickGetBucket(sbOut, memSrc);
-    IRExpr* entryNull = runZeroCheck64(sbOut, qresult.entry);
-    anyNonTrivialChains_32 = qresult.stillSearching32;
-    allNull_32 = runUnop(sbOut, Iop_1Uto32, entryNull);
-  } else {
-    QuickBucketResult qresults[MAX_TEMP_BLOCKS];
-    for(int i = 0; i < INT(size); ++i){
-      qresults[i] = quickGetBucket(sbOut,
-                                   runBinop(sbOut, Iop_Add64, memSrc,
-                                            mkU64(i * sizeof(float))));
-      IRExpr* entryNull = runZeroCheck64(sbOut, qresults[i].entry);
-      if (i == 0){
-        anyNonTrivialChains_32 = qresults[i].stillSearching32;
-        allNull_32 = runUnop(sbOut, Iop_1Uto32, entryNull);
-      } else {
-        anyNonTrivialChains_32 = runBinop(sbOut, Iop_Or32,
-                                          anyNonTrivialChains_32,
-                                          qresults[i].stillSearching32);
-        allNull_32 = runBinop(sbOut, Iop_And32, allNull_32,
-                              runUnop(sbOut, Iop_1Uto32, entryNull));
-      }
-    }
-  }
-  tl_assert(anyNonTrivialChains_32 != NULL);
-  tl_assert(allNull_32 != NULL);
-  IRExpr* goToC = runUnop(sbOut, Iop_32to1,
-                          runBinop(sbOut, Iop_Or32,
-                                   anyNonTrivialChains_32,
-                                   runUnop(sbOut, Iop_Not32,
-                                           allNull_32)));
-  return runITE(sbOut, goToC,
-                runGetMemG(sbOut, goToC, size, memSrc),
-                mkU64(0));
+  return runGetMemUnknownG(sbOut, mkU1(True), size, memSrc);
 }
 IRExpr* runGetMemG(IRSB* sbOut, IRExpr* guard, FloatBlocks size, IRExpr* memSrc){
   IRTemp result = newIRTemp(sbOut->tyenv, Ity_I64);
@@ -908,8 +913,8 @@ IRExpr* runGetMemG(IRSB* sbOut, IRExpr* guard, FloatBlocks size, IRExpr* memSrc)
                       mkIRExprVec_2(memSrc, mkU64(INT(size))));
   loadDirty->guard = guard;
   loadDirty->mFx = Ifx_Read;
-  loadDirty->mAddr = mkU64((uintptr_t)shadowMemTable);
-  loadDirty->mSize = sizeof(TableValueEntry) * LARGE_PRIME;
+  loadDirty->mAddr = mkU64((uintptr_t)primaryMap);
+  loadDirty->mSize = sizeof(primaryMap);
   addStmtToIRSB(sbOut, IRStmt_Dirty(loadDirty));
   return runITE(sbOut, guard, IRExpr_RdTmp(result), mkU64(0));
 }
@@ -921,8 +926,8 @@ IRExpr* runGetMem(IRSB* sbOut, FloatBlocks size, IRExpr* memSrc){
                       VG_(fnptr_to_fnentry)(dynamicLoad),
                       mkIRExprVec_2(memSrc, mkU64(INT(size))));
   loadDirty->mFx = Ifx_Read;
-  loadDirty->mAddr = mkU64((uintptr_t)shadowMemTable);
-  loadDirty->mSize = sizeof(TableValueEntry) * LARGE_PRIME;
+  loadDirty->mAddr = mkU64((uintptr_t)primaryMap);
+  loadDirty->mSize = sizeof(primaryMap);
   addStmtToIRSB(sbOut, IRStmt_Dirty(loadDirty));
   return IRExpr_RdTmp(result);
 }
@@ -930,23 +935,8 @@ void addClearMem(IRSB* sbOut, FloatBlocks size, IRExpr* memDest){
   addClearMemG(sbOut, mkU1(True), size, memDest);
 }
 void addClearMemG(IRSB* sbOut, IRExpr* guard, FloatBlocks size, IRExpr* memDest){
-  IRExpr* hasExistingShadow = mkU1(False);
-  for(int i = 0; i < INT(size); ++i){
-    IRExpr* valDest = runBinop(sbOut, Iop_Add64, memDest,
-                               mkU64(i * sizeof(float)));
-    IRExpr* destBucket = runMod(sbOut, valDest, mkU32(LARGE_PRIME));
-    IRExpr* destBucketAddr =
-      runBinop(sbOut, Iop_Add64,
-               mkU64((uintptr_t)shadowMemTable),
-               runBinop(sbOut, Iop_Mul64,
-                        destBucket,
-                        mkU64(sizeof(TableValueEntry*))));
-    IRExpr* memEntry = runLoad64(sbOut, destBucketAddr);
-    hasExistingShadow = runOr(sbOut, hasExistingShadow,
-                              runNonZeroCheck64(sbOut, memEntry));
-  }
   addSetMemG(sbOut,
-             runAnd(sbOut, hasExistingShadow, guard),
+             runMemMaybeShadowedG(sbOut, guard, size, memDest),
              size, memDest, mkU64(0));
 }
 void addSetMemUnknownG(IRSB* sbOut, IRExpr* guard, FloatBlocks size,
@@ -987,8 +977,8 @@ void addSetMemG(IRSB* sbOut, IRExpr* guard, FloatBlocks size,
                       mkIRExprVec_3(memDest, mkU64(INT(size)), newTemp));
   storeDirty->guard = guard;
   storeDirty->mFx = Ifx_Modify;
-  storeDirty->mAddr = mkU64((uintptr_t)shadowMemTable);
-  storeDirty->mSize = sizeof(TableValueEntry) * LARGE_PRIME;
+  storeDirty->mAddr = mkU64((uintptr_t)primaryMap);
+  storeDirty->mSize = sizeof(primaryMap);
   addStmtToIRSB(sbOut, IRStmt_Dirty(storeDirty));
 }
 IRExpr* toDoubleBytes(IRSB* sbOut, IRExpr* floatExpr){
@@ -114,14 +114,12 @@ void addStoreTempNonFloat(IRSB* sbOut, int idx);
 void addStoreTempUnknown(IRSB* sbOut, IRExpr* shadow_temp_maybe, int idx);
 void addStoreTempCopy(IRSB* sbOut, IRExpr* original, IRTemp dest);
 
-IRExpr* getBucketAddr(IRSB* sbOut, IRExpr* memAddr);
-typedef struct {
-  IRExpr* entry;
-  IRExpr* stillSearching32;
-} QuickBucketResult;
-QuickBucketResult quickGetBucket(IRSB* sbOut, IRExpr* memAddr);
-QuickBucketResult quickGetBucketG(IRSB* sbOut, IRExpr* guard,
-                                  IRExpr* memAddr);
+IRExpr* runTSValAddr(IRSB* sbOut, IRExpr* tsIdx);
+IRExpr* runMaybeShadowed(IRSB* sbOut, IRExpr* memAddr);
+IRExpr* getBucketAddrG(IRSB* sbOut, IRExpr* guard, IRExpr* memAddr);
+IRExpr* runMemMaybeShadowedG(IRSB* sbOut, IRExpr* guard,
+                             FloatBlocks size, IRExpr* memAddr);
+void addCountG(IRSB* sbOut, ULong* counter, IRExpr* cond);
 IRExpr* runGetMemUnknown(IRSB* sbOut, FloatBlocks size, IRExpr* memSrc);
 IRExpr* runGetMemUnknownG(IRSB* sbOut, IRExpr* guard,
                           FloatBlocks size, IRExpr* memSrc);
@@ -32,6 +32,7 @@
 
 #include "instrument-storage.h"
 #include "instrument-op.h"
+#include "semantic-op.h"
 
 // Pull in this header file so that we can call the valgrind version
 // of printf.
@@ -61,6 +62,7 @@ IRSB* hg_instrument (VgCallbackClosure* closure,
     printSuperBlock(sbIn);
   }
   inferTypes(sbIn);
+  planFusedOps(sbIn);
   if (PRINT_RUN_BLOCKS){
     char* blockMessage = VG_(perm_malloc)(35, 1);
     VG_(snprintf)(blockMessage, 35,
@@ -264,8 +266,7 @@ void instrumentStatement(IRSB* sbOut, IRStmt* stmt,
   case Ist_LLSC:
     VG_(dmsg)("Warning! Herbgrind does not currently support "
               "the Load Linked / Store Conditional set of "
-              "instructions, because we don't support multithreaded "
-              "programs.\n");
+              "instructions.\n");
     break;
   case Ist_Dirty:
     break;
@@ -44,6 +44,8 @@ void initOwnership(void){
 void cleanupBlockOwnership(IRSB* sbOut, IRExpr* guard){
   if (VG_(sizeXA)(tempDebt) == 0){
     addStoreGC(sbOut, guard, mkU64(0), &blockStateDirty);
+    addDeferredFreeFlush(sbOut, guard);
+    addCollectionCheck(sbOut, guard);
     return;
   }
   IRTemp* curDebtContents =
@@ -62,6 +64,31 @@ void cleanupBlockOwnership(IRSB* sbOut, IRExpr* guard){
   dynCleanupDirty->mAddr = mkU64((uintptr_t)shadowTemps);
   dynCleanupDirty->mSize = sizeof(ShadowTemp) * MAX_TEMPS;
   addStmtToIRSB(sbOut, IRStmt_Dirty(dynCleanupDirty));
+  addCollectionCheck(sbOut, guard);
+}
+// Blocks with no temps to clean up don't call dynamicCleanup, but
+// they can still drop values into the deferred free buffer, through
+// stores or disowns. So flush it at their exits too, when there's
+// anything in it.
+void addDeferredFreeFlush(IRSB* sbOut, IRExpr* guard){
+  if (shadow_gc != Gc_RefCount) return;
+  IRExpr* pending =
+    runNonZeroCheck64(sbOut, runLoad64C(sbOut, &numDeferredFrees));
+  addStmtToIRSB(sbOut,
+                mkDirtyG_0_N(0, "flushDeferredFrees",
+                             flushDeferredFrees, mkIRExprVec_0(),
+                             runAnd(sbOut, guard, pending)));
+}
+// With --shadow-gc=mark-sweep, nothing is owned or disowned in the
+// translated code. Instead, once the block's temps are cleaned up,
+// we collect if enough values have been made since last time.
+void addCollectionCheck(IRSB* sbOut, IRExpr* guard){
+  if (shadow_gc != Gc_MarkSweep) return;
+  IRExpr* pending = runNonZeroCheck64(sbOut, runLoad64C(sbOut, &gcPending));
+  addStmtToIRSB(sbOut,
+                mkDirtyG_0_N(0, "collectShadowValues",
+                             collectShadowValues, mkIRExprVec_0(),
+                             runAnd(sbOut, guard, pending)));
 }
 
 void resetOwnership(IRSB* sbOut){
@@ -140,14 +167,17 @@ void addDisownG(IRSB* sbOut, IRExpr* guard, IRExpr* shadow_temp, int num_vals){
                 shadow_temp);
 }
 void addSVOwn(IRSB* sbOut, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* valueNonNull = runNonZeroCheck64(sbOut, sv);
   addSVOwnNonNullG(sbOut, valueNonNull, sv);
 }
 void addSVOwnG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* valueNonNull = runNonZeroCheck64(sbOut, sv);
   addSVOwnNonNullG(sbOut, runAnd(sbOut, valueNonNull, guard), sv);
 }
 void addSVOwnNonNullG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* prevRefCount =
     runArrowG(sbOut, guard, sv, ShadowValue, ref_count);
   IRExpr* newRefCount =
@@ -158,6 +188,7 @@ void addSVOwnNonNullG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
   }
 }
 void addSVOwnNonNull(IRSB* sbOut, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* prevRefCount =
     runArrow(sbOut, sv, ShadowValue, ref_count);
   IRExpr* newRefCount =
@@ -168,10 +199,12 @@ void addSVOwnNonNull(IRSB* sbOut, IRExpr* sv){
   addStoreArrow(sbOut, sv, ShadowValue, ref_count, newRefCount);
 }
 void addSVDisown(IRSB* sbOut, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* valueNonNull = runNonZeroCheck64(sbOut, sv);
   addSVDisownNonNullG(sbOut, valueNonNull, sv);
 }
 void addSVDisownNonNull(IRSB* sbOut, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* refCountAddr =
     runArrowAddr(sbOut, sv, ShadowValue, ref_count);
   IRExpr* prevRefCount =
@@ -181,10 +214,11 @@ void addSVDisownNonNull(IRSB* sbOut, IRExpr* sv){
   addStore(sbOut, newRefCount, refCountAddr);
   IRExpr* lastRef = runBinop(sbOut, Iop_CmpEQ64, prevRefCount, mkU64(1));
   IRStmt* freeVal =
-    mkDirtyG_0_1(freeShadowValue, sv, lastRef);
+    mkDirtyG_0_1(deferFreeShadowValue, sv, lastRef);
   addStmtToIRSB(sbOut, freeVal);
 }
 void addSVDisownNonNullG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* refCountAddr =
     runArrowAddr(sbOut, sv, ShadowValue, ref_count);
   IRExpr* prevRefCount =
@@ -194,10 +228,11 @@ void addSVDisownNonNullG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
   addStoreG(sbOut, guard, newRefCount, refCountAddr);
   IRExpr* lastRef = runBinop(sbOut, Iop_CmpEQ64, prevRefCount, mkU64(1));
   IRStmt* freeVal =
-    mkDirtyG_0_1(freeShadowValue, sv, lastRef);
+    mkDirtyG_0_1(deferFreeShadowValue, sv, lastRef);
   addStmtToIRSB(sbOut, freeVal);
 }
 void addSVDisownG(IRSB* sbOut, IRExpr* guard, IRExpr* sv){
+  if (shadow_gc == Gc_MarkSweep) return;
   IRExpr* valueNonNull = runNonZeroCheck64(sbOut, sv);
   IRExpr* shouldDoAnythingAtAll = runAnd(sbOut, valueNonNull, guard);
   addSVDisownNonNullG(sbOut, shouldDoAnythingAtAll, sv);
@@ -37,6 +37,8 @@ extern XArray* tempDebt;
 
 void initOwnership(void);
 void cleanupBlockOwnership(IRSB* sbOut, IRExpr* guard);
+void addDeferredFreeFlush(IRSB* sbOut, IRExpr* guard);
+void addCollectionCheck(IRSB* sbOut, IRExpr* guard);
 void resetOwnership(IRSB* sbOut);
 void cleanupAtEndOfBlock(IRSB* sbOut, IRTemp shadowed_temp);
 void addDynamicDisown(IRSB* sbOut, IRTemp idx);
@@ -44,10 +44,250 @@
 #include "../runtime/value-shadowstate/value-shadowstate.h"
 
 #include "instrument-storage.h"
+#include "instrument-op.h"
 #include "ownership.h"
 
 VgHashTable* opInfoTable = NULL;
 
+// Before instrumenting a block, we find the scalar ops whose result
+// is only used by one later scalar op, with no exits in between.
+// Those don't get a helper call of their own; instead, they're run
+// as part of the call for the op that uses them (see
+// executeFusedShadowOps).
+static Int tempUses[MAX_TEMPS];
+static Int tempDefStmt[MAX_TEMPS];
+static Int opsInChain[MAX_TEMPS];
+static Bool fusedForward[MAX_TEMPS];
+
+typedef struct _PendingFusedOp {
+  ShadowOpInfoInstance* instance;
+  int nargs;
+  IRExpr* argExprs[3];
+} PendingFusedOp;
+static PendingFusedOp pendingFusedOps[MAX_TEMPS];
+
+static IRExpr* runDoubleBits(IRSB* sbOut, IRExpr* expr);
+
+static void countTempUses(IRExpr* expr){
+  switch(expr->tag){
+  case Iex_RdTmp:
+    tempUses[expr->Iex.RdTmp.tmp]++;
+    break;
+  case Iex_GetI:
+    countTempUses(expr->Iex.GetI.ix);
+    break;
+  case Iex_Qop:
+    countTempUses(expr->Iex.Qop.details->arg1);
+    countTempUses(expr->Iex.Qop.details->arg2);
+    countTempUses(expr->Iex.Qop.details->arg3);
+    countTempUses(expr->Iex.Qop.details->arg4);
+    break;
+  case Iex_Triop:
+    countTempUses(expr->Iex.Triop.details->arg1);
+    countTempUses(expr->Iex.Triop.details->arg2);
+    countTempUses(expr->Iex.Triop.details->arg3);
+    break;
+  case Iex_Binop:
+    countTempUses(expr->Iex.Binop.arg1);
+    countTempUses(expr->Iex.Binop.arg2);
+    break;
+  case Iex_Unop:
+    countTempUses(expr->Iex.Unop.arg);
+    break;
+  case Iex_Load:
+    countTempUses(expr->Iex.Load.addr);
+    break;
+  case Iex_ITE:
+    countTempUses(expr->Iex.ITE.cond);
+    countTempUses(expr->Iex.ITE.iftrue);
+    countTempUses(expr->Iex.ITE.iffalse);
+    break;
+  case Iex_CCall:
+    for(int i = 0; expr->Iex.CCall.args[i] != NULL; ++i){
+      countTempUses(expr->Iex.CCall.args[i]);
+    }
+    break;
+  default:
+    break;
+  }
+}
+static void countStmtTempUses(IRStmt* stmt){
+  switch(stmt->tag){
+  case Ist_WrTmp:
+    countTempUses(stmt->Ist.WrTmp.data);
+    break;
+  case Ist_Put:
+    countTempUses(stmt->Ist.Put.data);
+    break;
+  case Ist_PutI:
+    countTempUses(stmt->Ist.PutI.details->ix);
+    countTempUses(stmt->Ist.PutI.details->data);
+    break;
+  case Ist_Store:
+    countTempUses(stmt->Ist.Store.addr);
+    countTempUses(stmt->Ist.Store.data);
+    break;
+  case Ist_StoreG:
+    countTempUses(stmt->Ist.StoreG.details->addr);
+    countTempUses(stmt->Ist.StoreG.details->data);
+    countTempUses(stmt->Ist.StoreG.details->guard);
+    break;
+  case Ist_LoadG:
+    countTempUses(stmt->Ist.LoadG.details->addr);
+    countTempUses(stmt->Ist.LoadG.details->alt);
+    countTempUses(stmt->Ist.LoadG.details->guard);
+    break;
+  case Ist_CAS:
+    countTempUses(stmt->Ist.CAS.details->addr);
+    if (stmt->Ist.CAS.details->expdHi != NULL){
+      countTempUses(stmt->Ist.CAS.details->expdHi);
+    }
+    countTempUses(stmt->Ist.CAS.details->expdLo);
+    if (stmt->Ist.CAS.details->dataHi != NULL){
+      countTempUses(stmt->Ist.CAS.details->dataHi);
+    }
+    countTempUses(stmt->Ist.CAS.details->dataLo);
+    break;
+  case Ist_LLSC:
+    countTempUses(stmt->Ist.LLSC.addr);
+    if (stmt->Ist.LLSC.storedata != NULL){
+      countTempUses(stmt->Ist.LLSC.storedata);
+    }
+    break;
+  case Ist_Dirty:
+    countTempUses(stmt->Ist.Dirty.details->guard);
+    for(int i = 0; stmt->Ist.Dirty.details->args[i] != NULL; ++i){
+      countTempUses(stmt->Ist.Dirty.details->args[i]);
+    }
+    if (stmt->Ist.Dirty.details->mAddr != NULL){
+      countTempUses(stmt->Ist.Dirty.details->mAddr);
+    }
+    break;
+  case Ist_Exit:
+    countTempUses(stmt->Ist.Exit.guard);
+    break;
+  default:
+    break;
+  }
+}
+// Whether this statement will go through instrumentSemanticOp as a
+// scalar op. If it will, gets the op and its arguments.
+static Bool isScalarSemanticStmt(IRStmt* stmt, IROp* op_code,
+                                 int* nargs, IRExpr** argExprs){
+  if (stmt->tag != Ist_WrTmp) return False;
+  switch(stmt->Ist.WrTmp.data->tag){
+  case Iex_Qop:
+  case Iex_Triop:
+  case Iex_Binop:
+  case Iex_Unop:
+    break;
+  default:
+    return False;
+  }
+  getOpArgs(stmt->Ist.WrTmp.data, op_code, nargs, argExprs);
+  return isSemanticOp(*op_code) && getOpDescriptor(*op_code)->isScalar;
+}
+void planFusedOps(IRSB* sbIn){
+  int numTemps = sbIn->tyenv->types_used;
+  tl_assert(numTemps <= MAX_TEMPS);
+  for(int i = 0; i < numTemps; ++i){
+    tempUses[i] = 0;
+    tempDefStmt[i] = -1;
+    opsInChain[i] = 0;
+    fusedForward[i] = False;
+  }
+  if (dummy || no_fuse_ops) return;
+  for(int i = 0; i < sbIn->stmts_used; ++i){
+    countStmtTempUses(sbIn->stmts[i]);
+  }
+  int lastExit = -1;
+  for(int i = 0; i < sbIn->stmts_used; ++i){
+    IRStmt* stmt = sbIn->stmts[i];
+    if (stmt->tag == Ist_Exit){
+      lastExit = i;
+    }
+    IROp op_code;
+    int nargs;
+    IRExpr* argExprs[4];
+    if (!isScalarSemanticStmt(stmt, &op_code, &nargs, argExprs)){
+      continue;
+    }
+    IRTemp dest = stmt->Ist.WrTmp.tmp;
+    int chainSize = 1;
+    for(int j = 0; j < nargs; ++j){
+      if (argExprs[j]->tag != Iex_RdTmp) continue;
+      IRTemp arg = argExprs[j]->Iex.RdTmp.tmp;
+      if (tempUses[arg] == 1 && tempDefStmt[arg] > lastExit &&
+          chainSize + opsInChain[arg] <= MAX_FUSED_OPS){
+        fusedForward[arg] = True;
+        chainSize += opsInChain[arg];
+      }
+    }
+    tempDefStmt[dest] = i;
+    opsInChain[dest] = chainSize;
+  }
+}
+// Adds the ops that were fused into this one, then this one, to the
+// chain, and stores their client values for the helper. Returns this
+// op's index in the chain.
+static int addToFusedChain(IRSB* sbOut, FusedChain* chain,
+                           ShadowOpInfoInstance* instance,
+                           int nargs, IRExpr** argExprs,
+                           IRExpr* result){
+  FusedOp fusedOp = {.instance = instance, .argOps = {-1, -1, -1}};
+  for(int i = 0; i < nargs; ++i){
+    if (argExprs[i]->tag == Iex_RdTmp &&
+        fusedForward[argExprs[i]->Iex.RdTmp.tmp]){
+      IRTemp arg = argExprs[i]->Iex.RdTmp.tmp;
+      PendingFusedOp* pending = &(pendingFusedOps[arg]);
+      fusedOp.argOps[i] =
+        addToFusedChain(sbOut, chain, pending->instance,
+                        pending->nargs, pending->argExprs,
+                        IRExpr_RdTmp(arg));
+    }
+  }
+  int idx = chain->numOps++;
+  tl_assert(idx < MAX_FUSED_OPS);
+  chain->ops[idx] = fusedOp;
+  for(int i = 0; i < nargs; ++i){
+    addStoreC(sbOut, runDoubleBits(sbOut, argExprs[i]),
+              &(fusedClientValues[idx][i]));
+    if (argExprs[i]->tag != Iex_RdTmp){
+      instance->argTemps[i] = -1;
+    } else {
+      instance->argTemps[i] = argExprs[i]->Iex.RdTmp.tmp;
+      if (fusedOp.argOps[i] == -1){
+        cleanupAtEndOfBlock(sbOut, argExprs[i]->Iex.RdTmp.tmp);
+        tempShadowStatus[argExprs[i]->Iex.RdTmp.tmp] = Ss_Shadowed;
+      }
+    }
+  }
+  addStoreC(sbOut, runDoubleBits(sbOut, result),
+            &(fusedClientValues[idx][3]));
+  return idx;
+}
+static IRExpr* runFusedShadowOps(IRSB* sbOut,
+                                 ShadowOpInfoInstance* instance,
+                                 int nargs, IRExpr** argExprs,
+                                 IRTemp dest){
+  FusedChain* chain =
+    VG_(perm_malloc)(sizeof(FusedChain), vg_alignof(FusedChain));
+  chain->numOps = 0;
+  addToFusedChain(sbOut, chain, instance, nargs, argExprs,
+                  IRExpr_RdTmp(dest));
+  cleanupAtEndOfBlock(sbOut, dest);
+  IRTemp shadowDest = newIRTemp(sbOut->tyenv, Ity_I64);
+  IRDirty* dirty =
+    unsafeIRDirty_1_N(shadowDest, 1, "executeFusedShadowOps",
+                      VG_(fnptr_to_fnentry)(executeFusedShadowOps),
+                      mkIRExprVec_1(mkU64((uintptr_t)chain)));
+  dirty->mFx = Ifx_Read;
+  dirty->mAddr = mkU64((uintptr_t)fusedClientValues);
+  dirty->mSize = sizeof(fusedClientValues);
+  addStmtToIRSB(sbOut, IRStmt_Dirty(dirty));
+  return IRExpr_RdTmp(shadowDest);
+}
+
 long int cmpSemOpInfoEntry(const void* node1, const void* node2){
   const SemOpInfoEntry* entry1 = (const SemOpInfoEntry*)node1;
   const SemOpInfoEntry* entry2 = (const SemOpInfoEntry*)node2;
@@ -74,6 +314,28 @@ void instrumentSemanticOp(IRSB* sbOut, IROp op_code,
     addPrintOp(op_code);
     addPrint("\n");
   }
+  if (fusedForward[dest]){
+    // This gets run by whatever uses it.
+    PendingFusedOp* pending = &(pendingFusedOps[dest]);
+    pending->instance =
+      getSemanticOpInfoInstance(curAddr, blockAddr, op_code,
+                                nargs, argExprs);
+    pending->nargs = nargs;
+    for(int i = 0; i < nargs; ++i){
+      pending->argExprs[i] = argExprs[i];
+    }
+    return;
+  }
+  if (opsInChain[dest] > 1){
+    ShadowOpInfoInstance* instance =
+      getSemanticOpInfoInstance(curAddr, blockAddr, op_code,
+                                nargs, argExprs);
+    IRExpr* shadowOutput =
+      runFusedShadowOps(sbOut, instance, nargs, argExprs, dest);
+    addStoreTemp(sbOut, shadowOutput, dest);
+    tempShadowStatus[dest] = Ss_Shadowed;
+    return;
+  }
   IRExpr* shadowOutput = runShadowOp(sbOut, mkU1(True),
                                      op_code,
                                      curAddr, blockAddr,
@@ -88,6 +350,64 @@ void instrumentSemanticOp(IRSB* sbOut, IROp op_code,
   tempShadowStatus[dest] = Ss_Shadowed;
 }
 
+// Get the bits of a float expression as a double, which is how the
+// scalar shadow op helper takes its client values.
+static IRExpr* runDoubleBits(IRSB* sbOut, IRExpr* expr){
+  switch(typeOfIRExpr(sbOut->tyenv, expr)){
+  case Ity_F64:
+    return runUnop(sbOut, Iop_ReinterpF64asI64, expr);
+  case Ity_F32:
+    return runUnop(sbOut, Iop_ReinterpF64asI64,
+                   runUnop(sbOut, Iop_F32toF64, expr));
+  case Ity_I64:
+    return expr;
+  case Ity_I32:
+    return runF32toF64(sbOut, expr);
+  default:
+    tl_assert(0);
+    return NULL;
+  }
+}
+// Scalar ops get their client arguments and result passed straight
+// to the helper, instead of going through computedArgs and
+// computedResult in memory.
+static IRExpr* runScalarShadowOp(IRSB* sbOut, IRExpr* guard,
+                                 ShadowOpInfoInstance* instance,
+                                 int nargs, IRExpr** argExprs,
+                                 IRExpr* result){
+  tl_assert(nargs <= 3);
+  IRExpr* argBits[3];
+  for(int i = 0; i < 3; ++i){
+    if (i < nargs){
+      argBits[i] = runDoubleBits(sbOut, argExprs[i]);
+      if (argExprs[i]->tag == Iex_RdTmp){
+        instance->argTemps[i] = argExprs[i]->Iex.RdTmp.tmp;
+        cleanupAtEndOfBlock(sbOut, argExprs[i]->Iex.RdTmp.tmp);
+      } else {
+        instance->argTemps[i] = -1;
+      }
+    } else {
+      argBits[i] = mkU64(0);
+    }
+  }
+  IRExpr* resultBits = runDoubleBits(sbOut, result);
+  if (result->tag == Iex_RdTmp){
+    cleanupAtEndOfBlock(sbOut, result->Iex.RdTmp.tmp);
+  }
+  IRTemp dest = newIRTemp(sbOut->tyenv, Ity_I64);
+  IRDirty* dirty =
+    unsafeIRDirty_1_N(dest, 3, "executeScalarShadowOp",
+                      VG_(fnptr_to_fnentry)(executeScalarShadowOp),
+                      mkIRExprVec_5(mkU64((uintptr_t)instance),
+                                    argBits[0], argBits[1], argBits[2],
+                                    resultBits));
+  dirty->mFx = Ifx_Read;
+  dirty->mAddr = mkU64((uintptr_t)shadowTemps);
+  dirty->mSize = sizeof(shadowTemps);
+  dirty->guard = guard;
+  addStmtToIRSB(sbOut, IRStmt_Dirty(dirty));
+  return IRExpr_RdTmp(dest);
+}
 IRExpr* runShadowOp(IRSB* sbOut, IRExpr* guard,
                     IROp op_code,
                     Addr curAddr, Addr block_addr,
@@ -99,6 +419,10 @@ IRExpr* runShadowOp(IRSB* sbOut, IRExpr* guard,
   ShadowOpInfoInstance* instance =
     getSemanticOpInfoInstance(curAddr, block_addr, op_code,
                               nargs, argExprs);
+  if (instance->info->desc->isScalar){
+    return runScalarShadowOp(sbOut, guard, instance,
+                             nargs, argExprs, result);
+  }
   for(int i = 0; i < nargs; ++i){
     addStoreC(sbOut, argExprs[i],
               (uintptr_t)
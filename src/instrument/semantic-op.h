@@ -36,6 +36,7 @@
 #include "../runtime/value-shadowstate/shadowval.h"
 #include "../runtime/op-shadowstate/shadowop-info.h"
 
+void planFusedOps(IRSB* sbIn);
 void instrumentSemanticOp(IRSB* sbOut, IROp op_code,
                           int nargs, IRExpr** argExprs,
                           Addr curAddr, Addr blockAddr,
@@ -63,6 +63,7 @@ Bool print_type_inference = False;
 Bool print_inferred_types = False;
 Bool print_statement_numbers = False;
 Bool print_bit_twiddles = False;
+Bool print_shadow_stats = False;
 Int longprint_len = 15;
 
 Bool dont_ignore_pure_zeroes = False;
@@ -90,11 +91,17 @@ Bool no_influences = False;
 Bool no_reals = False;
 Bool use_ranges = True;
 Bool dummy = False;
+Bool no_fuse_ops = False;
+Bool no_batch_lanes = False;
 
 Int precision = 1000;
+Int start_precision = 0;
+RealType real_type = Rt_MPFR;
+ShadowGCType shadow_gc = Gc_RefCount;
 Int max_expr_block_depth = 5;
 double error_threshold = 5.0;
 Int max_influences = 20;
+Int shadow_memory_limit = 0;
 const char* output_filename = NULL;
 
 // Called to process each command line option.
@@ -124,6 +131,7 @@ Bool hg_process_cmd_line_option(const HChar* arg){
   else if VG_XACT_CLO(arg, "--print-inferred-types", print_inferred_types, True) {}
   else if VG_XACT_CLO(arg, "--print-statement-numbers", print_statement_numbers, True) {}
   else if VG_XACT_CLO(arg, "--print-bit-twiddles", print_bit_twiddles, True) {}
+  else if VG_XACT_CLO(arg, "--print-shadow-stats", print_shadow_stats, True) {}
   else if VG_XACT_CLO(arg, "--output-subexpr-sources", print_subexpr_locations, True) {}
   else if VG_XACT_CLO(arg, "--dont-ignore-pure-zeroes", dont_ignore_pure_zeroes, True) {}
   else if VG_XACT_CLO(arg, "--no-sound-simplify", sound_simplify, False) {}
@@ -150,12 +158,25 @@ Bool hg_process_cmd_line_option(const HChar* arg){
   else if VG_XACT_CLO(arg, "--no-reals", no_reals, True) {}
   else if VG_XACT_CLO(arg, "--no-ranges", use_ranges, False) {}
   else if VG_XACT_CLO(arg, "--dummy", dummy, True) {}
+  else if VG_XACT_CLO(arg, "--no-fuse-ops", no_fuse_ops, True) {}
+  else if VG_XACT_CLO(arg, "--no-batch-lanes", no_batch_lanes, True) {}
+  else if VG_XACT_CLO(arg, "--real-type=mpfr", real_type, Rt_MPFR) {}
+  else if VG_XACT_CLO(arg, "--real-type=double-double",
+                      real_type, Rt_DoubleDouble) {}
+  else if VG_XACT_CLO(arg, "--real-type=triple-double",
+                      real_type, Rt_TripleDouble) {}
+  else if VG_XACT_CLO(arg, "--shadow-gc=refcount", shadow_gc, Gc_RefCount) {}
+  else if VG_XACT_CLO(arg, "--shadow-gc=mark-sweep",
+                      shadow_gc, Gc_MarkSweep) {}
 
   else if VG_BINT_CLO(arg, "--longprint-len", longprint_len, 1, 1000) {}
   else if VG_BINT_CLO(arg, "--precision", precision, MPFR_PREC_MIN, MPFR_PREC_MAX){}
+  else if VG_BINT_CLO(arg, "--start-precision", start_precision, 64, MPFR_PREC_MAX){}
   else if VG_BINT_CLO(arg, "--max-expr-block-depth", max_expr_block_depth, 1, 100) {}
   else if VG_DBL_CLO(arg, "--error-threshold", error_threshold) {}
   else if VG_BINT_CLO(arg, "--max-influences", max_influences, 1, 1000) {}
+  else if VG_BINT_CLO(arg, "--shadow-memory-limit", shadow_memory_limit,
+                      0, 1024 * 1024) {}
   else if VG_STR_CLO(arg, "--outfile", output_filename) {}
   else return False;
   return True;
@@ -164,6 +185,17 @@ Bool hg_process_cmd_line_option(const HChar* arg){
 void hg_print_usage(void){
   VG_(printf)("    --precision=value    "
               "Sets the mantissa size of the shadow \"real\" values. [1000]\n"
+              "    --real-type=mpfr|double-double|triple-double    "
+              "How to represent the shadow \"real\" values. The "
+              "double-double (106 bit) and triple-double (159 bit) "
+              "types ignore --precision, and are much faster. [mpfr]\n"
+              "    --start-precision=value    "
+              "Start every operation at this many bits instead of "
+              "--precision, and only raise an operation's precision "
+              "when its results lose too many bits to cancellation or "
+              "can't be rounded to a double with confidence. Raised "
+              "precisions never go past --precision. Only applies to "
+              "mpfr reals. [off]\n"
               "    --error-threshold=bits    "
               "The number of bits of error at which to start "
               "tracking a computation. [5.0]\n"
@@ -173,6 +205,16 @@ void hg_print_usage(void){
               "    --outfile=name    "
               "The name of the file to write out. If no name is "
               "specified, will use <executable-name>.gh.\n"
+              "    --shadow-memory-limit=megabytes    "
+              "Roughly how much memory to spend shadowing values in "
+              "memory. Past this, the least recently used shadows are "
+              "thrown out, and those locations go back to their client "
+              "values. 0 means no limit. [0]\n"
+              "    --shadow-gc=refcount|mark-sweep    "
+              "How to reclaim shadow values. With mark-sweep, values "
+              "aren't reference counted as they move around; instead, "
+              "the ones that can't be reached from registers or memory "
+              "are swept up every so often. [refcount]\n"
               "    --output-sexp    "
               "Output in an easy-to-parse s-expression based format.\n"
               "    --output-subexpr-sources    "
@@ -251,6 +293,14 @@ void hg_print_debug_usage(void){
               "Start's the analysis with the running flag set to off\n"
               " --always-on "
               "Ignore calls to HERBGRIND_END()\n"
+              " --print-shadow-stats "
+              "Count memory shadow lookups, and print statistics "
+              "about the shadow memory at exit.\n"
+              " --no-fuse-ops "
+              "Give every shadow op its own helper call, instead of "
+              "running chains of scalar ops in one.\n"
+              " --no-batch-lanes "
+              "Run the lanes of SIMD shadow ops one at a time.\n"
               " --longprint-len=length "
               "How many digits of long real values to print.\n"
               " --print-flagged "
@@ -32,6 +32,23 @@
 
 #include "pub_tool_basics.h"
 
+// How shadow reals are represented. Besides MPFR at --precision
+// bits, we can use an unevaluated sum of two or three doubles, which
+// is much cheaper and usually plenty to see rounding error.
+typedef enum {
+  Rt_MPFR,
+  Rt_DoubleDouble,
+  Rt_TripleDouble,
+} RealType;
+
+// How shadow values get reclaimed. Either every move of a value
+// updates its reference count, or nothing is counted and unreachable
+// values are swept up every so often.
+typedef enum {
+  Gc_RefCount,
+  Gc_MarkSweep,
+} ShadowGCType;
+
 extern int running_depth;
 extern Bool always_on;
 
@@ -64,6 +81,7 @@ extern Bool print_type_inference;
 extern Bool print_inferred_types;
 extern Bool print_statement_numbers;
 extern Bool print_bit_twiddles;
+extern Bool print_shadow_stats;
 extern Int longprint_len;
 
 extern Bool dont_ignore_pure_zeroes;
@@ -91,11 +109,17 @@ extern Bool no_influences;
 extern Bool no_reals;
 extern Bool use_ranges;
 extern Bool dummy;
+extern Bool no_fuse_ops;
+extern Bool no_batch_lanes;
 
 extern Int precision;
+extern Int start_precision;
+extern RealType real_type;
+extern ShadowGCType shadow_gc;
 extern Int max_expr_block_depth;
 extern double error_threshold;
 extern Int max_influences;
+extern Int shadow_memory_limit;
 extern const char* output_filename;
 
 #define USE_MPFR
@@ -29,7 +29,7 @@
 
 #include "marks.h"
 #include "../../helper/runtime-util.h"
-#include "../value-shadowstate/shadowval.h"
+#include "../value-shadowstate/value-shadowstate.h"
 #include "../shadowop/error.h"
 #include "../shadowop/influence-op.h"
 #include "../shadowop/symbolic-op.h"
@@ -47,15 +47,16 @@ void maybeMarkImportantAtAddr(ShadowValue* val, double clientValue,
                               int argIdx, int nargs, Addr callAddr){
   if (no_influences) return;
   if (val == NULL) return;
+  materializeShadowValue(val);
   MarkInfo* info = getMarkInfo(callAddr, argIdx, nargs);
   double thisError =
     updateError(&(info->eagg), val->real, clientValue);
   if (thisError >= error_threshold){
-    inPlaceMergeInfluences(&(info->influences), val->influences);
+    inPlaceMergeInfluences(&(info->influences), val->cold->influences);
   }
   if (!no_exprs && output_mark_exprs){
-    tl_assert(val->expr != NULL);
-    generalizeSymbolicExpr(&(info->expr), val->expr);
+    tl_assert(val->cold->expr != NULL);
+    generalizeSymbolicExpr(&(info->expr), val->cold->expr);
   }
 }
 void markImportant(ShadowValue* val, double clientValue, int argIdx, int nargs){
@@ -72,14 +73,15 @@ void markImportant(ShadowValue* val, double clientValue, int argIdx, int nargs){
     info->eagg.num_evals += 1;
     return;
   }
+  materializeShadowValue(val);
   double thisError =
     updateError(&(info->eagg), val->real, clientValue);
   if (thisError >= error_threshold){
-    inPlaceMergeInfluences(&(info->influences), val->influences);
+    inPlaceMergeInfluences(&(info->influences), val->cold->influences);
   }
   if (!no_exprs && output_mark_exprs){
-    tl_assert(val->expr != NULL);
-    generalizeSymbolicExpr(&(info->expr), val->expr);
+    tl_assert(val->cold->expr != NULL);
+    generalizeSymbolicExpr(&(info->expr), val->cold->expr);
   }
 }
 void markEscapeFromFloat(const char* markType,
@@ -96,12 +98,13 @@ void markEscapeFromFloat(const char* markType,
     info->nargs = num_vals;
   }
   for(int i = 0; i < num_vals; ++i){
+    materializeShadowValue(values[i]);
     if (mismatch){
-      inPlaceMergeInfluences(&(info->influences), values[i]->influences);
+      inPlaceMergeInfluences(&(info->influences), values[i]->cold->influences);
     }
     if (!no_exprs && output_mark_exprs){
-      tl_assert(values[i]->expr != NULL);
-      generalizeSymbolicExpr(&(info->exprs[i]), values[i]->expr);
+      tl_assert(values[i]->cold->expr != NULL);
+      generalizeSymbolicExpr(&(info->exprs[i]), values[i]->cold->expr);
     }
   }
 }
@@ -39,6 +39,7 @@
 #include "../../options.h"
 
 #include "../shadowop/symbolic-op.h"
+#include "../value-shadowstate/value-shadowstate.h"
 #include "../../helper/runtime-util.h"
 
 #define ENTRY_BUFFER_SIZE 2048000
@@ -55,6 +56,25 @@ void writeOutput(void){
   }
   Int fileD = sr_Res(fileResult);
 
+  // If we had to throw out shadows to stay under the memory limit,
+  // the errors reported below might be underestimates, so say so.
+  if (numEvictedMemShadows > 0){
+    char _buf[256];
+    BBuf* buf = mkBBuf(256, _buf);
+    if (output_sexp){
+      printBBuf(buf, "(shadow-evictions %llu)\n", numEvictedMemShadows);
+    } else {
+      printBBuf(buf,
+                "%llu memory shadows were evicted to stay under "
+                "--shadow-memory-limit=%d, so some error may be "
+                "missing below.\n\n",
+                numEvictedMemShadows, shadow_memory_limit);
+    }
+    unsigned int entryLen = 256 - buf->bound;
+    VG_(write)(fileD, _buf, entryLen);
+    VG_(printf)("Evicted %llu memory shadows.\n", numEvictedMemShadows);
+  }
+
   if (VG_(HT_count_nodes)(markMap) == 0 &&
       !haveErroneousIntMarks()){
     if (!output_sexp){
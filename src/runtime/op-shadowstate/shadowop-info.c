@@ -36,6 +36,7 @@
 #include "../../helper/bbuf.h"
 #include "../../helper/runtime-util.h"
 #include "../shadowop/mathreplace.h"
+#include "../shadowop/shadowop.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -43,6 +44,8 @@
 VgHashTable* mathreplaceOpInfoMap = NULL;
 VgHashTable* semanticOpInfoMap = NULL;
 
+static OpDescriptor* opDescriptors[IEop_REALLY_LAST_FOR_REAL_GUYS];
+
 void initOpShadowState(void){
   mathreplaceOpInfoMap = VG_(HT_construct)("call map mathreplace");
   semanticOpInfoMap = VG_(HT_construct)("call map semantic op");
@@ -50,6 +53,63 @@ void initOpShadowState(void){
   intMarkMap = VG_(HT_construct)("int mark map");
 }
 
+const OpDescriptor* getOpDescriptor(IROp_Extended op_code){
+  tl_assert(op_code > IEop_INVALID &&
+            op_code < IEop_REALLY_LAST_FOR_REAL_GUYS);
+  if (opDescriptors[op_code] != NULL){
+    return opDescriptors[op_code];
+  }
+  OpDescriptor* desc =
+    VG_(perm_malloc)(sizeof(OpDescriptor), vg_alignof(OpDescriptor));
+  desc->numBlocks = numOpBlocks(op_code);
+  desc->numArgBlocks = numOpArgBlocks(op_code);
+  desc->nargs = getNativeNumFloatArgs(op_code);
+  desc->argPrecision = opArgPrecision(op_code);
+  desc->numOperandBlocks = INT(numOpOperandBlocks(op_code));
+  desc->numLanes = desc->numOperandBlocks /
+    (desc->argPrecision == Vt_Double ? 2 : 1);
+  tl_assert(desc->nargs <= 4);
+  tl_assert(desc->numLanes <= MAX_TEMP_BLOCKS);
+  desc->isScalar = desc->nargs <= 3 &&
+    (desc->argPrecision == Vt_Double || desc->argPrecision == Vt_Single) &&
+    desc->numOperandBlocks == (desc->argPrecision == Vt_Double ? 2 : 1) &&
+    INT(desc->numBlocks) == desc->numOperandBlocks &&
+    INT(desc->numArgBlocks) == desc->numOperandBlocks;
+  desc->isMultiply = False;
+  desc->isAdd = False;
+  desc->isSubtract = False;
+  switch((int)op_code){
+  case Iop_Mul32F0x4:
+  case Iop_Mul64F0x2:
+  case Iop_Mul32Fx8:
+  case Iop_Mul64Fx4:
+  case Iop_Mul32Fx4:
+  case Iop_Mul64Fx2:
+  case Iop_MulF64:
+  case Iop_MulF128:
+  case Iop_MulF32:
+  case Iop_MulF64r32:
+    desc->isMultiply = True;
+    break;
+  case Iop_Add32F0x4:
+  case Iop_Add64F0x2:
+  case Iop_AddF64:
+  case Iop_AddF32:
+    desc->isAdd = True;
+    break;
+  case Iop_Sub32F0x4:
+  case Iop_Sub64F0x2:
+  case Iop_SubF64:
+  case Iop_SubF32:
+    desc->isSubtract = True;
+    break;
+  default:
+    break;
+  }
+  opDescriptors[op_code] = desc;
+  return desc;
+}
+
 ShadowOpInfo* mkShadowOpInfo(IROp_Extended op_code, OpType type,
                              Addr op_addr, Addr block_addr,
                              int nargs){
@@ -58,8 +118,10 @@ ShadowOpInfo* mkShadowOpInfo(IROp_Extended op_code, OpType type,
   result->op_addr = op_addr;
   result->block_addr = block_addr;
   result->op_type = type;
+  result->desc = op_code == 0 ? NULL : getOpDescriptor(op_code);
 
   result->expr = NULL;
+  result->precision = realPrecision();
   if (nargs != numFloatArgs(result)){
     printOpInfo(result);
     VG_(printf)("\n");
@@ -161,7 +223,7 @@ int numFloatArgs(ShadowOpInfo* opinfo){
   if (opinfo->op_code == 0){
     return getWrappedNumArgs(opinfo->op_type);
   } else {
-    return getNativeNumFloatArgs(opinfo->op_code);
+    return opinfo->desc->nargs;
   }
 }
 
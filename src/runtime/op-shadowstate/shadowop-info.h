@@ -62,15 +62,42 @@ typedef struct _Aggregate {
   InputsRecord inputs;
 } Aggregate;
 
+// Everything executeShadowOp needs to know about the shape of an op,
+// which only depends on the op code. These get worked out the first
+// time an op code is instrumented, so that running the op is just
+// reading fields.
+typedef struct _OpDescriptor {
+  FloatBlocks numBlocks;
+  FloatBlocks numArgBlocks;
+  int nargs;
+  int numOperandBlocks;
+  ValueType argPrecision;
+  // How many values the op works on in parallel. Doubles take up two
+  // blocks each.
+  int numLanes;
+  // Ops on a single float, with nothing to copy across from the
+  // other blocks, go through executeScalarShadowOp.
+  Bool isScalar;
+  // Which of the special cases in executeChannelShadowOp apply.
+  Bool isMultiply;
+  Bool isAdd;
+  Bool isSubtract;
+} OpDescriptor;
+
 typedef struct _ShadowOpInfo {
   // These two are mutually exclusive.
   IROp_Extended op_code;
   OpType op_type;
+  // Only for op_code ops.
+  const OpDescriptor* desc;
 
   Addr op_addr;
   Addr block_addr;
   Aggregate agg;
   SymbExpr* expr;
+  // The number of bits this op computes its shadow results at. Only
+  // changes with --start-precision.
+  Int precision;
 } ShadowOpInfo;
 
 typedef struct _ShadowOpInfoInstance {
@@ -99,6 +126,7 @@ typedef struct _semOpInfoEntry {
 
 
 void initOpShadowState(void);
+const OpDescriptor* getOpDescriptor(IROp_Extended op_code);
 ShadowOpInfo* mkShadowOpInfo(IROp_Extended op_code, OpType type,
                              Addr op_addr, Addr block_addr,
                              int nargs);
@@ -75,6 +75,39 @@ double updateError(ErrorAggregate* eagg,
   }
   return bitsError;
 }
+// Like updateError, for when we know the client computed the exact
+// answer, so we don't have to look at the shadow value.
+double recordExactEval(ErrorAggregate* eagg){
+  if (eagg->max_error < 0.0){
+    eagg->max_error = 0.0;
+  }
+  eagg->num_evals += 1;
+  if (print_errors_long || print_errors){
+    VG_(printf)("Computed exactly, 0 bits error\n");
+  }
+  return 0.0;
+}
+
+// The bits of error in a computed value, without recording it
+// anywhere.
+double bitsErrorOf(Real realVal, double computedVal){
+  return log2(ulpd(getDouble(realVal), computedVal) + 1);
+}
+// Records the errors of all the lanes of one SIMD op in one go.
+void recordLaneErrors(ErrorAggregate* eagg,
+                      double* bitsErrors, int numLanes){
+  double maxError = eagg->max_error;
+  double totalError = 0.0;
+  for(int i = 0; i < numLanes; ++i){
+    if (bitsErrors[i] > maxError){
+      maxError = bitsErrors[i];
+    }
+    totalError += bitsErrors[i];
+  }
+  eagg->max_error = maxError;
+  eagg->total_error += totalError;
+  eagg->num_evals += numLanes;
+}
 
 ULong ulpd(double x, double y){
   if (x == 0) x = 0; // -0 == 0
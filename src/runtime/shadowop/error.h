@@ -35,6 +35,10 @@
 
 double updateError(ErrorAggregate* eagg,
                    Real realVal, double computedVal);
+double recordExactEval(ErrorAggregate* eagg);
+double bitsErrorOf(Real realVal, double computedVal);
+void recordLaneErrors(ErrorAggregate* eagg,
+                      double* bitsErrors, int numLanes);
 ULong ulpd(double val1, double val2);
 
 #endif
@@ -37,6 +37,7 @@ VG_REGPARM(1) void checkCompare(ShadowCmpInfo* info){
   ShadowTemp* args[2];
   for(int i = 0; i < 2; ++i){
     args[i] = getArg(i, info->op_code, info->argTemps[i]);
+    materializeShadowTemp(args[i]);
   }
   int correctOutput;
   if (numSIMDOperands(info->op_code) == 1){
@@ -208,6 +209,7 @@ VG_REGPARM(1) void checkCompare(ShadowCmpInfo* info){
 VG_REGPARM(3) void checkConvert(IROp_Extended op, IRTemp tmp,
                                 Addr curAddr){
   ShadowTemp* arg = getArg(0, op, tmp);
+  materializeShadowTemp(arg);
   int correctResult = (int)getDouble(arg->values[0]->real);
   int computedValue =
     *((int*)&computedResult.f[0]);
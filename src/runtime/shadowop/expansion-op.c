@@ -0,0 +1,468 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie         expansion-op.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+
+#include "expansion-op.h"
+#include "../value-shadowstate/real.h"
+#include "../../helper/ir-info.h"
+
+#include <math.h>
+
+// The most terms we ever have to renormalize, which is a
+// triple-double multiply.
+#define MAX_EXPANSION_TERMS 16
+// 2^27 + 1, for splitting a double into two 26-bit halves.
+#define SPLITTER 134217729.0
+
+// These are the usual error-free transformations: s + e is exactly
+// a + b, and p + e is exactly a * b, as long as nothing overflows.
+static inline void twoSum(double a, double b, double* s, double* e){
+  double sum = a + b;
+  double bVirtual = sum - a;
+  *e = (a - (sum - bVirtual)) + (b - bVirtual);
+  *s = sum;
+}
+static inline void split(double a, double* hi, double* lo){
+  double t = SPLITTER * a;
+  *hi = t - (t - a);
+  *lo = a - *hi;
+}
+static inline void twoProd(double a, double b, double* p, double* e){
+  double aHi, aLo, bHi, bLo;
+  *p = a * b;
+  split(a, &aHi, &aLo);
+  split(b, &bHi, &bLo);
+  *e = ((aHi * bHi - *p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+}
+static inline Bool isFinite(double x){
+  return x - x == 0.0;
+}
+
+// Squash terms, which should be roughly in decreasing order of
+// magnitude, down to nout non-overlapping parts. We first sum from
+// the bottom up, which doesn't lose anything, and then peel parts off
+// the top, folding whatever's left into the last one.
+static void renormalize(double* terms, int nterms, double* out, int nout){
+  double s = terms[nterms - 1];
+  for(int i = nterms - 2; i >= 0; --i){
+    twoSum(terms[i], s, &s, &(terms[i + 1]));
+  }
+  terms[0] = s;
+  int k = 0;
+  for(int i = 1; i < nterms; ++i){
+    if (k == nout - 1){
+      s += terms[i];
+      continue;
+    }
+    double e;
+    twoSum(s, terms[i], &s, &e);
+    if (e != 0.0){
+      out[k++] = s;
+      s = e;
+    }
+  }
+  out[k++] = s;
+  for(; k < nout; ++k){
+    out[k] = 0.0;
+  }
+}
+// If anything went to infinity or NaN along the way, the parts are
+// garbage, so just use what plain double arithmetic would give.
+static void checkFinite(double* out, int n, double plainResult){
+  for(int i = 0; i < n; ++i){
+    if (!isFinite(out[i])){
+      out[0] = plainResult;
+      for(int j = 1; j < n; ++j){
+        out[j] = 0.0;
+      }
+      return;
+    }
+  }
+}
+
+static void expansionAdd(const double* a, const double* b,
+                         double* out, int n){
+  double terms[2 * MAX_REAL_PARTS];
+  for(int i = 0; i < n; ++i){
+    terms[2 * i] = a[i];
+    terms[2 * i + 1] = b[i];
+  }
+  renormalize(terms, 2 * n, out, n);
+  checkFinite(out, n, a[0] + b[0]);
+}
+static void expansionNeg(const double* a, double* out, int n){
+  for(int i = 0; i < n; ++i){
+    out[i] = -a[i];
+  }
+}
+static void expansionSub(const double* a, const double* b,
+                         double* out, int n){
+  double negB[MAX_REAL_PARTS];
+  expansionNeg(b, negB, n);
+  expansionAdd(a, negB, out, n);
+}
+// Products of parts whose indices add up to less than n are done
+// exactly; the ones adding up to exactly n are small enough that the
+// rounded product will do, and anything smaller is dropped.
+static void expansionMul(const double* a, const double* b,
+                         double* out, int n){
+  double terms[MAX_EXPANSION_TERMS];
+  double errors[MAX_REAL_PARTS];
+  int nterms = 0;
+  int nerrors = 0;
+  for(int level = 0; level <= n; ++level){
+    // The errors from the last level are about as big as this one's
+    // products.
+    for(int i = 0; i < nerrors; ++i){
+      terms[nterms++] = errors[i];
+    }
+    nerrors = 0;
+    for(int i = 0; i <= level; ++i){
+      int j = level - i;
+      if (i >= n || j >= n){
+        continue;
+      }
+      if (level < n){
+        twoProd(a[i], b[j], &(terms[nterms]), &(errors[nerrors++]));
+        nterms++;
+      } else {
+        terms[nterms++] = a[i] * b[j];
+      }
+    }
+  }
+  renormalize(terms, nterms, out, n);
+  checkFinite(out, n, a[0] * b[0]);
+}
+// Long division: each quotient part is the leading part of the
+// remainder divided by the leading part of the divisor.
+static void expansionDiv(const double* a, const double* b,
+                         double* out, int n){
+  double quotients[MAX_REAL_PARTS + 1];
+  double remainder[MAX_REAL_PARTS];
+  double product[MAX_REAL_PARTS];
+  double q[MAX_REAL_PARTS] = {0.0, 0.0, 0.0};
+  for(int i = 0; i < n; ++i){
+    remainder[i] = a[i];
+  }
+  for(int k = 0; k <= n; ++k){
+    quotients[k] = remainder[0] / b[0];
+    if (k == n){
+      break;
+    }
+    q[0] = quotients[k];
+    expansionMul(q, b, product, n);
+    expansionSub(remainder, product, remainder, n);
+  }
+  renormalize(quotients, n + 1, out, n);
+  checkFinite(out, n, a[0] / b[0]);
+}
+// Newton's method, starting from the double square root. Each step
+// doubles the number of correct bits.
+static void expansionSqrt(const double* a, double* out, int n){
+  double x[MAX_REAL_PARTS] = {sqrt(a[0]), 0.0, 0.0};
+  double square[MAX_REAL_PARTS];
+  double twoX[MAX_REAL_PARTS];
+  double step[MAX_REAL_PARTS];
+  for(int bits = 53; bits < 53 * n; bits *= 2){
+    expansionMul(x, x, square, n);
+    expansionSub(a, square, square, n);
+    for(int i = 0; i < n; ++i){
+      twoX[i] = 2.0 * x[i];
+    }
+    expansionDiv(square, twoX, step, n);
+    expansionAdd(x, step, x, n);
+  }
+  for(int i = 0; i < n; ++i){
+    out[i] = x[i];
+  }
+  checkFinite(out, n, sqrt(a[0]));
+}
+static void expansionNaN(double* out, int n){
+  out[0] = 0.0 / 0.0;
+  for(int i = 1; i < n; ++i){
+    out[i] = 0.0;
+  }
+}
+static void expansionCopy(const double* a, double* out, int n){
+  for(int i = 0; i < n; ++i){
+    out[i] = a[i];
+  }
+}
+static int expansionCompare(const double* a, const double* b, int n){
+  for(int i = 0; i < n; ++i){
+    if (a[i] < b[i]) return -1;
+    if (a[i] > b[i]) return 1;
+  }
+  return 0;
+}
+
+Bool execExpansionOp(IROp op_code, Real result, ShadowValue** args){
+  int n = numRealParts();
+  double* out = result->parts;
+  for(int i = n; i < MAX_REAL_PARTS; ++i){
+    out[i] = 0.0;
+  }
+  switch((int)op_code){
+  case Iop_Abs32Fx4:
+  case Iop_Abs32Fx2:
+  case Iop_Abs64Fx2:
+  case Iop_AbsF32:
+  case Iop_AbsF64:
+    if (args[0]->real->parts[0] < 0){
+      expansionNeg(args[0]->real->parts, out, n);
+    } else {
+      expansionCopy(args[0]->real->parts, out, n);
+    }
+    return True;
+  case Iop_Neg32Fx4:
+  case IEop_Neg32F0x4:
+  case Iop_Neg32Fx2:
+  case Iop_Neg64Fx2:
+  case IEop_Neg64F0x2:
+  case Iop_NegF32:
+  case Iop_NegF64:
+    expansionNeg(args[0]->real->parts, out, n);
+    return True;
+  case Iop_SqrtF64:
+  case Iop_SqrtF32:
+  case Iop_Sqrt32F0x4:
+  case Iop_Sqrt64F0x2:
+  case Iop_Sqrt64Fx2:
+    if (args[0]->real->parts[0] < 0.0){
+      expansionNaN(out, n);
+    } else if (args[0]->real->parts[0] == 0.0){
+      expansionCopy(args[0]->real->parts, out, n);
+    } else {
+      expansionSqrt(args[0]->real->parts, out, n);
+    }
+    return True;
+  case Iop_Add64Fx4:
+  case Iop_Add64Fx2:
+  case Iop_Add64F0x2:
+  case Iop_Add32F0x4:
+  case Iop_Add32Fx2:
+  case Iop_Add32Fx4:
+  case Iop_Add32Fx8:
+  case Iop_AddF128:
+  case Iop_AddF64:
+  case Iop_AddF32:
+  case Iop_AddF64r32:
+    expansionAdd(args[0]->real->parts, args[1]->real->parts, out, n);
+    return True;
+  case Iop_Sub64F0x2:
+  case Iop_Sub32F0x4:
+  case Iop_Sub32Fx2:
+  case Iop_Sub32Fx8:
+  case Iop_Sub64Fx4:
+  case Iop_Sub32Fx4:
+  case Iop_Sub64Fx2:
+  case Iop_SubF128:
+  case Iop_SubF32:
+  case Iop_SubF64:
+  case Iop_SubF64r32:
+    expansionSub(args[0]->real->parts, args[1]->real->parts, out, n);
+    return True;
+  case Iop_Mul32F0x4:
+  case Iop_Mul64F0x2:
+  case Iop_Mul32Fx8:
+  case Iop_Mul64Fx4:
+  case Iop_Mul32Fx4:
+  case Iop_Mul64Fx2:
+  case Iop_MulF128:
+  case Iop_MulF64:
+  case Iop_MulF32:
+  case Iop_MulF64r32:
+    expansionMul(args[0]->real->parts, args[1]->real->parts, out, n);
+    return True;
+  case Iop_Div32F0x4:
+  case Iop_Div64F0x2:
+  case Iop_Div32Fx8:
+  case Iop_Div64Fx4:
+  case Iop_Div32Fx4:
+  case Iop_DivF128:
+  case Iop_DivF64:
+  case Iop_DivF32:
+  case Iop_DivF64r32:
+  case Iop_Div64Fx2:
+    // Same as the MPFR version, dividing by zero gives NaN.
+    if (args[1]->real->parts[0] == 0.0){
+      expansionNaN(out, n);
+    } else {
+      expansionDiv(args[0]->real->parts, args[1]->real->parts, out, n);
+    }
+    return True;
+  case Iop_Max64F0x2:
+  case Iop_Max64Fx2:
+  case Iop_Max32F0x4:
+  case Iop_Max32Fx4:
+  case Iop_Max32Fx2:
+  case Iop_Min64F0x2:
+  case Iop_Min64Fx2:
+  case Iop_Min32F0x4:
+  case Iop_Min32Fx4:
+  case Iop_Min32Fx2:
+    {
+      double* a = args[0]->real->parts;
+      double* b = args[1]->real->parts;
+      Bool isMax = op_code == Iop_Max64F0x2 || op_code == Iop_Max64Fx2 ||
+        op_code == Iop_Max32F0x4 || op_code == Iop_Max32Fx4 ||
+        op_code == Iop_Max32Fx2;
+      // Like mpfr_max and mpfr_min, if one side is NaN, take the
+      // other.
+      if (a[0] != a[0]){
+        expansionCopy(b, out, n);
+      } else if (b[0] != b[0]){
+        expansionCopy(a, out, n);
+      } else if ((expansionCompare(a, b, n) > 0) == isMax){
+        expansionCopy(a, out, n);
+      } else {
+        expansionCopy(b, out, n);
+      }
+    }
+    return True;
+  case Iop_MAddF32:
+  case Iop_MAddF64:
+  case Iop_MAddF64r32:
+    {
+      double product[MAX_REAL_PARTS];
+      expansionMul(args[0]->real->parts, args[1]->real->parts, product, n);
+      expansionAdd(product, args[2]->real->parts, out, n);
+    }
+    return True;
+  case Iop_MSubF32:
+  case Iop_MSubF64:
+  case Iop_MSubF64r32:
+    {
+      double product[MAX_REAL_PARTS];
+      expansionMul(args[0]->real->parts, args[1]->real->parts, product, n);
+      expansionSub(product, args[2]->real->parts, out, n);
+    }
+    return True;
+  default:
+    return False;
+  }
+}
+
+// Products, quotients, and square roots of values in this range
+// can't overflow, and their error terms can't underflow, so the
+// error-free transformations give us the exact residue.
+#define MIN_SAFE_EFT 0x1p-480
+#define MAX_SAFE_EFT 0x1p480
+static inline Bool inSafeRange(double x){
+  return fabs(x) >= MIN_SAFE_EFT && fabs(x) <= MAX_SAFE_EFT;
+}
+static Bool isExactSum(double a, double b, double clientResult){
+  double s, e;
+  twoSum(a, b, &s, &e);
+  return isFinite(s) && e == 0.0 && s == clientResult;
+}
+static Bool isExactProduct(double a, double b, double clientResult){
+  if (!isFinite(a) || !isFinite(b)) return False;
+  if (a == 0.0 || b == 0.0) return clientResult == 0.0;
+  if (!inSafeRange(a) || !inSafeRange(b) || !inSafeRange(clientResult)){
+    return False;
+  }
+  double p, e;
+  twoProd(a, b, &p, &e);
+  return e == 0.0 && p == clientResult;
+}
+
+Bool isExactOp(IROp op_code, double* clientArgs, double clientResult){
+  switch((int)op_code){
+  case Iop_Abs32Fx4:
+  case Iop_Abs32Fx2:
+  case Iop_Abs64Fx2:
+  case Iop_AbsF32:
+  case Iop_AbsF64:
+  case Iop_Neg32Fx4:
+  case IEop_Neg32F0x4:
+  case Iop_Neg32Fx2:
+  case Iop_Neg64Fx2:
+  case IEop_Neg64F0x2:
+  case Iop_NegF32:
+  case Iop_NegF64:
+    return isFinite(clientArgs[0]);
+  case Iop_Add64Fx4:
+  case Iop_Add64Fx2:
+  case Iop_Add64F0x2:
+  case Iop_Add32F0x4:
+  case Iop_Add32Fx2:
+  case Iop_Add32Fx4:
+  case Iop_Add32Fx8:
+  case Iop_AddF64:
+  case Iop_AddF32:
+  case Iop_AddF64r32:
+    return isExactSum(clientArgs[0], clientArgs[1], clientResult);
+  case Iop_Sub64F0x2:
+  case Iop_Sub32F0x4:
+  case Iop_Sub32Fx2:
+  case Iop_Sub32Fx8:
+  case Iop_Sub64Fx4:
+  case Iop_Sub32Fx4:
+  case Iop_Sub64Fx2:
+  case Iop_SubF32:
+  case Iop_SubF64:
+  case Iop_SubF64r32:
+    return isExactSum(clientArgs[0], -clientArgs[1], clientResult);
+  case Iop_Mul32F0x4:
+  case Iop_Mul64F0x2:
+  case Iop_Mul32Fx8:
+  case Iop_Mul64Fx4:
+  case Iop_Mul32Fx4:
+  case Iop_Mul64Fx2:
+  case Iop_MulF64:
+  case Iop_MulF32:
+  case Iop_MulF64r32:
+    return isExactProduct(clientArgs[0], clientArgs[1], clientResult);
+  case Iop_Div32F0x4:
+  case Iop_Div64F0x2:
+  case Iop_Div32Fx8:
+  case Iop_Div64Fx4:
+  case Iop_Div32Fx4:
+  case Iop_DivF64:
+  case Iop_DivF32:
+  case Iop_DivF64r32:
+  case Iop_Div64Fx2:
+    // The quotient was exact if multiplying it back out gives
+    // exactly the dividend. Multiplying back out doesn't tell us
+    // anything when dividing by zero (the shadow gives an infinity,
+    // or a NaN for 0/0), so we just don't take the shortcut.
+    if (clientArgs[1] == 0.0) return False;
+    return isExactProduct(clientResult, clientArgs[1], clientArgs[0]);
+  case Iop_SqrtF64:
+  case Iop_SqrtF32:
+  case Iop_Sqrt32F0x4:
+  case Iop_Sqrt64F0x2:
+  case Iop_Sqrt64Fx2:
+    if (!(clientArgs[0] >= 0.0)) return False;
+    return isExactProduct(clientResult, clientResult, clientArgs[0]);
+  default:
+    return False;
+  }
+}
@@ -44,27 +44,27 @@ void execInfluencesOp(ShadowOpInfo* info,
     return;
   }
   if (numFloatArgs(info) == 1){
-    *res = mergeInfluences(args[0]->influences, NULL,
+    *res = mergeInfluences(args[0]->cold->influences, NULL,
                            flagged ? info : NULL);
   } else if (numFloatArgs(info) == 2){
-    *res = mergeInfluences(args[0]->influences, args[1]->influences,
+    *res = mergeInfluences(args[0]->cold->influences, args[1]->cold->influences,
                            flagged ? info : NULL);
   } else if (numFloatArgs(info) == 3){
-    InfluenceList intermediary = mergeInfluences(args[0]->influences,
-                                                 args[1]->influences,
+    InfluenceList intermediary = mergeInfluences(args[0]->cold->influences,
+                                                 args[1]->cold->influences,
                                                  flagged ? info : NULL);
 
-    *res = mergeInfluences(intermediary, args[2]->influences, NULL);
+    *res = mergeInfluences(intermediary, args[2]->cold->influences, NULL);
     if (intermediary != NULL){
       freeInfluenceList(intermediary);
     }
   } else {
     tl_assert(numFloatArgs(info) == 4);
-    InfluenceList intermediary1 = mergeInfluences(args[0]->influences,
-                                                  args[1]->influences,
+    InfluenceList intermediary1 = mergeInfluences(args[0]->cold->influences,
+                                                  args[1]->cold->influences,
                                                   flagged ? info : NULL);
-    InfluenceList intermediary2 = mergeInfluences(args[2]->influences,
-                                                  args[3]->influences,
+    InfluenceList intermediary2 = mergeInfluences(args[2]->cold->influences,
+                                                  args[3]->cold->influences,
                                                   NULL);
     *res = mergeInfluences(intermediary1, intermediary2, NULL);
     if (intermediary1 != NULL){
@@ -87,11 +87,11 @@ void trackOpAsInfluence(ShadowOpInfo* info, ShadowValue* value){
   if (no_influences){
     return;
   }
-  InfluenceList lst = mergeInfluences(value->influences, NULL, info);
-  if (value->influences != NULL){
-    freeInfluenceList(value->influences);
+  InfluenceList lst = mergeInfluences(value->cold->influences, NULL, info);
+  if (value->cold->influences != NULL){
+    freeInfluenceList(value->cold->influences);
   }
-  value->influences = lst;
+  value->cold->influences = lst;
 }
 InfluenceList cloneInfluences(InfluenceList influences){
   return mergeInfluences(influences, NULL, NULL);
@@ -99,7 +99,8 @@ InfluenceList cloneInfluences(InfluenceList influences){
 
 void forceTrack(Addr varAddr){
   ShadowValue* val = getMemShadow(varAddr);
-  ShadowOpInfo* info = val->expr->branch.op;
+  materializeShadowValue(val);
+  ShadowOpInfo* info = val->cold->expr->branch.op;
   VG_(printf)("Tracking %p\n", val);
   trackOpAsInfluence(info, val);
 }
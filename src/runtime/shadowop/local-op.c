@@ -35,21 +35,30 @@
 #include "../../options.h"
 #include "pub_tool_libcprint.h"
 
-double execLocalOp(ShadowOpInfo* info, Real realVal,
-                   ShadowValue* res, ShadowValue** args){
-  if (no_reals) return 0;
+// What the client would have gotten for this op on the exact
+// arguments.
+static double locallyApproximateResult(ShadowOpInfo* info,
+                                       ShadowValue** args){
   int nargs = numFloatArgs(info);
   double exactRoundedArgs[4];
   for(int i = 0; i < nargs; ++i){
     exactRoundedArgs[i] = getDouble(args[i]->real);
   }
-  double locallyApproximateResult;
   if (info->op_code == 0x0){
-    locallyApproximateResult =
-      runEmulatedWrappedOp(info->op_type, exactRoundedArgs);
+    return runEmulatedWrappedOp(info->op_type, exactRoundedArgs);
   } else {
-    locallyApproximateResult =
-      runEmulatedOp(info->op_code, exactRoundedArgs);
+    return runEmulatedOp(info->op_code, exactRoundedArgs);
   }
-  return updateError(&(info->agg.local_error), realVal, locallyApproximateResult);
+}
+double execLocalOp(ShadowOpInfo* info, Real realVal,
+                   ShadowValue* res, ShadowValue** args){
+  if (no_reals) return 0;
+  return updateError(&(info->agg.local_error), realVal,
+                     locallyApproximateResult(info, args));
+}
+// Like execLocalOp, but leaves recording the error to the caller.
+double localBitsError(ShadowOpInfo* info, Real realVal,
+                      ShadowValue** args){
+  if (no_reals) return 0;
+  return bitsErrorOf(realVal, locallyApproximateResult(info, args));
 }
@@ -36,5 +36,7 @@
 
 double execLocalOp(ShadowOpInfo* info, Real realVal,
                    ShadowValue* res, ShadowValue** args);
+double localBitsError(ShadowOpInfo* info, Real realVal,
+                      ShadowValue** args);
 
 #endif
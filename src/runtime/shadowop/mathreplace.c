@@ -71,6 +71,7 @@ void performWrappedOp(OpType type, double* resLoc, double* args){
       // reference. This removes that.
       disownShadowValue(shadowArgs[i]);
     }
+    materializeShadowValue(shadowArgs[i]);
   }
   if (print_inputs){
     for(int i = 0; i < nargs; ++i){
@@ -94,12 +95,12 @@ void performWrappedOp(OpType type, double* resLoc, double* args){
   }
   double bitsGlobalError =
     updateError(&(info->agg.global_error), shadowResult->real, *resLoc);
-  execSymbolicOp(info, &(shadowResult->expr),
+  execSymbolicOp(info, &(shadowResult->cold->expr),
                  *resLoc, shadowArgs,
                  bitsGlobalError > error_threshold);
   double bitsLocalError =
     execLocalOp(info, shadowResult->real, shadowResult, shadowArgs);
-  execInfluencesOp(info, &(shadowResult->influences), shadowArgs,
+  execInfluencesOp(info, &(shadowResult->cold->influences), shadowArgs,
                    bitsLocalError >= error_threshold);
   if (print_influences){
     VG_(printf)("Propagating influences for op ");
@@ -107,10 +108,10 @@ void performWrappedOp(OpType type, double* resLoc, double* args){
     VG_(printf)(":\n");
     for(int i = 0; i < nargs; ++i){
       VG_(printf)("Arg %p has influences:\n", shadowArgs[i]);
-      ppInfluences(shadowArgs[i]->influences);
+      ppInfluences(shadowArgs[i]->cold->influences);
     }
     VG_(printf)("Value %p gets influences:\n", shadowResult);
-    ppInfluences(shadowResult->influences);
+    ppInfluences(shadowResult->cold->influences);
     VG_(printf)("\n");
   }
   if (print_semantic_ops){
@@ -205,6 +206,14 @@ const char* getWrappedName(OpType type){
 ShadowValue* runWrappedShadowOp(OpType type, ShadowValue** shadowArgs){
   ShadowValue* result = mkShadowValueBare(getWrappedPrecision(type));
   if (no_reals) return result;
+  // Library functions don't get their precision adapted, so just run
+  // them at the full precision.
+  if (adaptivePrecision()){
+    setRealPrecision(result->real, precision);
+  }
+  for(int i = 0; i < getWrappedNumArgs(type); ++i){
+    syncRealToMPFR(shadowArgs[i]->real);
+  }
   switch(type){
   case OP_CDIVR:
   case OP_CDIVI:
@@ -376,6 +385,7 @@ ShadowValue* runWrappedShadowOp(OpType type, ShadowValue** shadowArgs){
     tl_assert(0);
     return NULL;
   }
+  syncRealFromMPFR(result->real);
   return result;
 }
 
@@ -28,6 +28,7 @@
 */
 
 #include "realop.h"
+#include "expansion-op.h"
 #include "../value-shadowstate/real.h"
 #include "pub_tool_libcassert.h"
 #include "pub_tool_libcprint.h"
@@ -37,6 +38,15 @@ void execRealOp(IROp op_code, Real* result, ShadowValue** args){
   if (no_reals){
     return;
   }
+  if (real_type != Rt_MPFR){
+    if (execExpansionOp(op_code, *result, args)){
+      return;
+    }
+    // Anything we can't do on the parts directly goes through MPFR.
+    for(int i = 0; i < getNativeNumFloatArgs(op_code); ++i){
+      syncRealToMPFR(args[i]->real);
+    }
+  }
   switch((int)op_code){
   case Iop_RecipEst32Fx4:
   case Iop_RecipEst32Fx2:
@@ -282,6 +292,7 @@ void execRealOp(IROp op_code, Real* result, ShadowValue** args){
     tl_assert(0);
     return;
   }
+  syncRealFromMPFR(*result);
 }
 DEF1(recip){
   RET CALL2(ui_div, res, 1, arg);
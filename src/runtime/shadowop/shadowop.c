@@ -31,6 +31,7 @@
 #include "../value-shadowstate/value-shadowstate.h"
 #include "../value-shadowstate/range.h"
 #include "realop.h"
+#include "expansion-op.h"
 #include "pub_tool_libcprint.h"
 #include "pub_tool_libcassert.h"
 #include "error.h"
@@ -40,66 +41,80 @@
 #include "../../helper/ir-info.h"
 #include "../../helper/runtime-util.h"
 
+static Bool canBatchLanes(void);
+static void executeLaneShadowOps(ShadowOpInfo* opinfo, int numLanes,
+                                 ShadowValue* args[][4],
+                                 double clientArgs[][4],
+                                 double* clientResults,
+                                 ShadowValue** results);
+
 VG_REGPARM(1) ShadowTemp* executeShadowOp(ShadowOpInfoInstance* infoInstance){
   ShadowOpInfo* opInfo = infoInstance->info;
-  // Make sure the op code is sane, so that things don't go bonkers
-  // later.
-  tl_assert(((IROp)opInfo->op_code) > Iop_INVALID);
-  tl_assert(opInfo->op_code <
-            IEop_REALLY_LAST_FOR_REAL_GUYS);
+  // The op code was checked when the descriptor was made, at
+  // instrumentation time.
+  const OpDescriptor* desc = opInfo->desc;
 
   // Create a shadow temp for the result.
-  FloatBlocks numBlocks = numOpBlocks(opInfo->op_code);
-  FloatBlocks numArgBlocks = numOpArgBlocks(opInfo->op_code);
+  FloatBlocks numBlocks = desc->numBlocks;
+  FloatBlocks numArgBlocks = desc->numArgBlocks;
   ShadowTemp* result = mkShadowTemp(numBlocks);
 
-  // Get the computed and shadow arguments.
-  int nargs = numFloatArgs(opInfo);
-  tl_assert(nargs <= 4);
-  int numChannels = numChannelsOut(opInfo->op_code);
-  tl_assert(numChannels <= MAX_TEMP_BLOCKS);
+  // Get the computed and shadow arguments. Each lane of the op is
+  // one value, which takes up two blocks if it's a double.
+  int nargs = desc->nargs;
+  int numOperandBlocks = desc->numOperandBlocks;
+  ValueType argPrecision = desc->argPrecision;
+  int laneBlocks = argPrecision == Vt_Double ? 2 : 1;
+  int numLanes = desc->numLanes;
   ShadowTemp* args[4];
-  double clientArgs[4][MAX_TEMP_BLOCKS];
+  ShadowValue* laneArgs[MAX_TEMP_BLOCKS][4];
+  double clientArgs[MAX_TEMP_BLOCKS][4];
+  double clientResults[MAX_TEMP_BLOCKS];
   for(int i = 0; i < nargs; ++i){
     args[i] = getArg(i, opInfo->op_code, infoInstance->argTemps[i]);
     tl_assert2(INT(args[i]->num_blocks) == INT(numArgBlocks),
                "Arg has %d blocks, but op blocks is %d\n",
                INT(args[i]->num_blocks), INT(numArgBlocks));
-    for (int j = 0; j < numChannels; ++j){
-      ValueType argPrecision = opBlockArgPrecision(opInfo->op_code, j / 2);
-      clientArgs[j][i] = argPrecision == Vt_Double ?
-        computedArgs.argValues[i][j] :
-        computedArgs.argValuesF[i][j];
-    }
-  }
-  // Do the operation on the operand channels
-  int numOperandChannels = numSIMDOperands(opInfo->op_code);
-  int numOperandBlocks =
-    numOperandChannels * (opArgPrecision(opInfo->op_code) == Vt_Double ? 2 : 1);
-  for(int i = 0; i < numOperandBlocks; ++i){
-    ShadowValue* vals[MAX_TEMP_BLOCKS];
-    ValueType argPrecision = opArgPrecision(opInfo->op_code);
-    if (argPrecision == Vt_Double && i % 2 == 1){
-      result->values[i] = NULL;
-      continue;
-    }
-    for(int j = 0; j < nargs; ++j){
-      if (args[j]->values[i] == NULL){
-        args[j]->values[i] = mkShadowValue(argPrecision, clientArgs[i][j]);
+    for(int lane = 0; lane < numLanes; ++lane){
+      int block = lane * laneBlocks;
+      clientArgs[lane][i] = argPrecision == Vt_Double ?
+        computedArgs.argValues[i][lane] :
+        computedArgs.argValuesF[i][lane];
+      if (args[i]->values[block] == NULL){
+        args[i]->values[block] =
+          mkShadowValue(argPrecision, clientArgs[lane][i]);
         if (PRINT_VALUE_MOVES){
           VG_(printf)("Making shadow value %p for argument %d block %d (%p) in t%d.\n",
-                      args[j]->values[j], j, i, args[j], infoInstance->argTemps[i]);
+                      args[i]->values[block], i, block, args[i],
+                      infoInstance->argTemps[i]);
         }
       }
-      vals[j] = args[j]->values[i];
+      laneArgs[lane][i] = args[i]->values[block];
+    }
+  }
+  for(int lane = 0; lane < numLanes; ++lane){
+    clientResults[lane] = argPrecision == Vt_Single ?
+      computedResult.f[lane] : computedResult.d[lane];
+  }
+  // Do the operation on the operand channels
+  ShadowValue* laneResults[MAX_TEMP_BLOCKS];
+  if (numLanes > 1 && canBatchLanes()){
+    executeLaneShadowOps(opInfo, numLanes, laneArgs,
+                         clientArgs, clientResults, laneResults);
+  } else {
+    for(int lane = 0; lane < numLanes; ++lane){
+      laneResults[lane] =
+        executeChannelShadowOp(opInfo,
+                               laneArgs[lane],
+                               clientArgs[lane],
+                               clientResults[lane]);
+    }
+  }
+  for(int lane = 0; lane < numLanes; ++lane){
+    result->values[lane * laneBlocks] = laneResults[lane];
+    if (argPrecision == Vt_Double){
+      result->values[lane * laneBlocks + 1] = NULL;
     }
-    double computedOutput = (argPrecision == Vt_Single ?
-       computedResult.f[i] : computedResult.d[i / 2]);
-    result->values[i] =
-      executeChannelShadowOp(opInfo,
-                             vals,
-                             clientArgs[i],
-                             computedOutput);
   }
   // Copy across argument on the non-operand channels
   for(int i = numOperandBlocks; i < INT(numBlocks); ++i){
@@ -150,6 +165,125 @@ VG_REGPARM(1) ShadowTemp* executeShadowOp(ShadowOpInfoInstance* infoInstance){
   }
   return result;
 }
+// Like getArg, but for a scalar op, where we have the client value
+// right here.
+static ShadowTemp* getScalarArg(const OpDescriptor* desc, IRTemp argTemp,
+                                double clientValue){
+  if (argTemp != -1 && shadowTemps[argTemp] != NULL){
+    return shadowTemps[argTemp];
+  }
+  ShadowTemp* result = mkShadowTemp(desc->numArgBlocks);
+  result->values[0] = mkShadowValue(desc->argPrecision, clientValue);
+  if (desc->argPrecision == Vt_Double){
+    result->values[1] = NULL;
+  }
+  if (argTemp != -1){
+    if (PRINT_TEMP_MOVES){
+      VG_(printf)("Storing shadow temp %p (%d blocks) at t%d for argument\n",
+                  result, INT(desc->numArgBlocks), argTemp);
+    }
+    shadowTemps[argTemp] = result;
+  }
+  return result;
+}
+// The same as executeShadowOp, for ops on a single float, which is
+// most of them. There's only the one channel, and no blocks to copy
+// across, so this is straight-line. The client arguments and result
+// come in as the bits of doubles (singles are widened first), with
+// unused arguments zero.
+VG_REGPARM(3) ShadowTemp* executeScalarShadowOp(ShadowOpInfoInstance* infoInstance,
+                                                UWord arg0, UWord arg1,
+                                                UWord arg2, UWord clientResult){
+  ShadowOpInfo* opInfo = infoInstance->info;
+  const OpDescriptor* desc = opInfo->desc;
+  ValueType argPrecision = desc->argPrecision;
+  int nargs = desc->nargs;
+
+  ShadowTemp* result = mkShadowTemp(desc->numBlocks);
+  ShadowTemp* args[3];
+  ShadowValue* vals[3];
+  double clientArgs[3];
+  UWord argBits[3] = {arg0, arg1, arg2};
+  for(int i = 0; i < nargs; ++i){
+    clientArgs[i] = *(double*)&(argBits[i]);
+    args[i] = getScalarArg(desc, infoInstance->argTemps[i], clientArgs[i]);
+    if (args[i]->values[0] == NULL){
+      args[i]->values[0] = mkShadowValue(argPrecision, clientArgs[i]);
+    }
+    vals[i] = args[i]->values[0];
+  }
+  result->values[0] =
+    executeChannelShadowOp(opInfo, vals, clientArgs,
+                           *(double*)&clientResult);
+  if (argPrecision == Vt_Double){
+    result->values[1] = NULL;
+  }
+  if (PRINT_TEMP_MOVES){
+    VG_(printf)("Making %p for result of shadow op.\n",
+                result);
+  }
+  if (PRINT_VALUE_MOVES){
+    ppIROp_Extended(opInfo->op_code);
+    VG_(printf)(": Making value %p -> ", result->values[0]);
+  }
+
+  // Clean up any args we made for constants
+  for(int i = 0; i < nargs; ++i){
+    if (infoInstance->argTemps[i] == -1){
+      disownShadowTemp_fast(args[i]);
+    }
+  }
+  return result;
+}
+UWord fusedClientValues[MAX_FUSED_OPS][4];
+
+VG_REGPARM(1) ShadowTemp* executeFusedShadowOps(FusedChain* chain){
+  ShadowValue* opResults[MAX_FUSED_OPS];
+  for(int i = 0; i < chain->numOps; ++i){
+    FusedOp* fusedOp = &(chain->ops[i]);
+    ShadowOpInfoInstance* instance = fusedOp->instance;
+    const OpDescriptor* desc = instance->info->desc;
+    ShadowTemp* args[3];
+    ShadowValue* vals[3];
+    double clientArgs[3];
+    for(int j = 0; j < desc->nargs; ++j){
+      clientArgs[j] = *(double*)&(fusedClientValues[i][j]);
+      if (fusedOp->argOps[j] != -1){
+        vals[j] = opResults[fusedOp->argOps[j]];
+        continue;
+      }
+      args[j] = getScalarArg(desc, instance->argTemps[j], clientArgs[j]);
+      if (args[j]->values[0] == NULL){
+        args[j]->values[0] = mkShadowValue(desc->argPrecision, clientArgs[j]);
+      }
+      vals[j] = args[j]->values[0];
+    }
+    opResults[i] =
+      executeChannelShadowOp(instance->info, vals, clientArgs,
+                             *(double*)&(fusedClientValues[i][3]));
+    // Nothing else can see the values in between, so they're done
+    // with as soon as the op that uses them is.
+    for(int j = 0; j < desc->nargs; ++j){
+      if (fusedOp->argOps[j] != -1){
+        disownShadowValue(vals[j]);
+      } else if (instance->argTemps[j] == -1){
+        disownShadowTemp_fast(args[j]);
+      }
+    }
+  }
+  const OpDescriptor* lastDesc =
+    chain->ops[chain->numOps - 1].instance->info->desc;
+  ShadowTemp* result = mkShadowTemp(lastDesc->numBlocks);
+  result->values[0] = opResults[chain->numOps - 1];
+  if (lastDesc->argPrecision == Vt_Double){
+    result->values[1] = NULL;
+  }
+  if (PRINT_TEMP_MOVES){
+    VG_(printf)("Making %p for result of %d fused shadow ops.\n",
+                result, chain->numOps);
+  }
+  return result;
+}
 ShadowTemp* getArg(int argIdx, IROp op, IRTemp argTemp){
   if (argTemp == -1 ||
       shadowTemps[argTemp] == NULL){
@@ -191,7 +325,7 @@ ShadowTemp* getArg(int argIdx, IROp op, IRTemp argTemp){
 void ppInfluenceAddrs(ShadowValue* val);
 void ppInfluenceAddrs(ShadowValue* val){
   tl_assert(val != NULL);
-  InfluenceList list = val->influences;
+  InfluenceList list = val->cold->influences;
   if (list != NULL && list->length > 0){
     VG_(printf)("%lX", list->data[0]->op_addr);
     for(int i = 1; i < list->length; ++i){
@@ -199,6 +333,171 @@ void ppInfluenceAddrs(ShadowValue* val){
     }
   }
 }
+ULong numPrecisionEscalations = 0;
+ULong numExactShadowOps = 0;
+
+// Whether every shadow argument is exactly what the client had, so
+// that a client op that was exact needs no shadow computation.
+static Bool argsMatchClient(ShadowValue** args, double* clientArgs,
+                            int nargs){
+  for(int i = 0; i < nargs; ++i){
+    if (!realEqualsDouble(args[i]->real, clientArgs[i])){
+      return False;
+    }
+  }
+  return True;
+}
+
+static Bool isCancellingOp(IROp_Extended op_code){
+  switch((int)op_code){
+  case Iop_Add32F0x4:
+  case Iop_Add64F0x2:
+  case Iop_Add32Fx4:
+  case Iop_Add64Fx2:
+  case Iop_Add32Fx8:
+  case Iop_Add64Fx4:
+  case Iop_AddF64:
+  case Iop_AddF32:
+  case Iop_AddF128:
+  case Iop_Sub32F0x4:
+  case Iop_Sub64F0x2:
+  case Iop_Sub32Fx4:
+  case Iop_Sub64Fx2:
+  case Iop_Sub32Fx8:
+  case Iop_Sub64Fx4:
+  case Iop_SubF64:
+  case Iop_SubF32:
+  case Iop_SubF128:
+    return True;
+  default:
+    return False;
+  }
+}
+
+// With --start-precision, check that a result we just computed
+// still has enough good bits to round to a double. Ops that cancel
+// lose bits off the top, and any op can land too close to a rounding
+// boundary to tell which way it goes. When that happens, raise the
+// precision of this op, and of the ops that produced its arguments
+// so they come in better next time, and redo the op if that will
+// help.
+static void adaptPrecision(ShadowOpInfo* opinfo, ShadowValue* result,
+                           ShadowValue** args, int nargs){
+  #ifdef USE_MPFR
+  while(opinfo->precision < precision){
+    mpfr_ptr resultVal = result->real->mpfr_val;
+    if (!mpfr_regular_p(resultVal)) return;
+
+    // Leaves came straight from doubles, so they're exact no matter
+    // what precision they're stored at.
+    Int argPrecision = precision;
+    mpfr_exp_t maxArgExp = mpfr_get_exp(resultVal);
+    for(int i = 0; i < nargs; ++i){
+      mpfr_ptr argVal = args[i]->real->mpfr_val;
+      ConcExpr* argExpr = args[i]->cold->expr;
+      if (argExpr == NULL || argExpr->type != Node_Leaf){
+        if (mpfr_get_prec(argVal) < argPrecision){
+          argPrecision = mpfr_get_prec(argVal);
+        }
+      }
+      if (mpfr_regular_p(argVal) && mpfr_get_exp(argVal) > maxArgExp){
+        maxArgExp = mpfr_get_exp(argVal);
+      }
+    }
+    Int lostBits = 0;
+    if (isCancellingOp(opinfo->op_code)){
+      lostBits = maxArgExp - mpfr_get_exp(resultVal);
+    }
+    Int goodBits = mpfr_get_prec(resultVal);
+    if (argPrecision < goodBits){
+      goodBits = argPrecision;
+    }
+    goodBits -= lostBits + 2;
+    if (goodBits > 55 &&
+        mpfr_can_round(resultVal, goodBits, MPFR_RNDN, MPFR_RNDZ, 54)){
+      return;
+    }
+
+    Int oldPrecision = opinfo->precision;
+    opinfo->precision = oldPrecision * 2;
+    if (oldPrecision + lostBits + 64 > opinfo->precision){
+      opinfo->precision = oldPrecision + lostBits + 64;
+    }
+    if (opinfo->precision > precision){
+      opinfo->precision = precision;
+    }
+    numPrecisionEscalations++;
+    for(int i = 0; i < nargs; ++i){
+      ConcExpr* argExpr = args[i]->cold->expr;
+      if (argExpr != NULL && argExpr->type == Node_Branch &&
+          argExpr->branch.op->precision < opinfo->precision){
+        argExpr->branch.op->precision = opinfo->precision;
+      }
+    }
+    // If the arguments were what held us back, computing this one
+    // over won't get any more good bits out of them.
+    if (oldPrecision >= argPrecision) return;
+    setRealPrecision(result->real, opinfo->precision);
+    execRealOp(opinfo->op_code, &(result->real), args);
+  }
+  #endif
+}
+
+// Whether this is a multiply where one of the client arguments is
+// zero, so we don't bother propagating anything through it.
+static Bool isPureZeroMultiply(ShadowOpInfo* opinfo, ShadowValue** args,
+                               double* clientArgs){
+  return !dont_ignore_pure_zeroes && !no_reals && opinfo->desc->isMultiply &&
+    ((clientArgs[0] == 0 && !isNaN(args[1]->real)) ||
+     (clientArgs[1] == 0 && !isNaN(args[0]->real)));
+}
+// Gives the result of an op its influences, from its arguments and
+// its own local error.
+static void propagateInfluences(ShadowOpInfo* opinfo,
+                                ShadowValue* result,
+                                ShadowValue** args,
+                                double* clientArgs,
+                                double clientResult,
+                                double bitsLocalError){
+  int nargs = opinfo->desc->nargs;
+  if (compensation_detection && !no_reals &&
+      (opinfo->desc->isAdd || opinfo->desc->isSubtract)){
+    // Both adds and subtracts are considered compensating if their
+    // second argument is zero in the reals (and the error decreases),
+    // but only adds also are compensating if their first argument is
+    // zero in the reals.
+    if (opinfo->desc->isAdd && getDouble(args[0]->real) == 0){
+      ULong inputError = ulpd(getDouble(args[1]->real), clientArgs[1]);
+      ULong outputError = ulpd(getDouble(result->real), clientResult);
+      if (outputError <= inputError){
+        result->cold->influences = cloneInfluences(args[1]->cold->influences);
+        return;
+      }
+    }
+    if (getDouble(args[1]->real) == 0){
+      ULong inputError = ulpd(getDouble(args[0]->real), clientArgs[0]);
+      ULong outputError = ulpd(getDouble(result->real), clientResult);
+      if (outputError <= inputError){
+        result->cold->influences = cloneInfluences(args[0]->cold->influences);
+        return;
+      }
+    }
+  }
+  execInfluencesOp(opinfo, &(result->cold->influences), args,
+                   bitsLocalError >= error_threshold);
+  if (print_influences){
+    VG_(printf)("Propagating influences for op ");
+    printOpInfo(opinfo);
+    VG_(printf)(":\n");
+    for(int i = 0; i < nargs; ++i){
+      VG_(printf)("Arg %p has influences:\n", args[i]);
+      ppInfluences(args[i]->cold->influences);
+    }
+    VG_(printf)("Value %p gets influences:\n", result);
+    ppInfluences(result->cold->influences);
+    VG_(printf)("\n");
+  }
+}
 ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
                                     ShadowValue** args,
                                     double* clientArgs,
@@ -212,45 +511,30 @@ ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
   // instruction where the value types DON'T have to match (*32F0x4
   // and *64F0x2), then we should only be run on the first value in
   // that instruction.
-  ValueType argPrecision = opArgPrecision(opinfo->op_code);
-  int nargs = numFloatArgs(opinfo);
-  if (!dont_ignore_pure_zeroes && !no_reals){
-    switch((int)opinfo->op_code){
-    case Iop_Mul32F0x4:
-    case Iop_Mul64F0x2:
-    case Iop_Mul32Fx8:
-    case Iop_Mul64Fx4:
-    case Iop_Mul32Fx4:
-    case Iop_Mul64Fx2:
-    case Iop_MulF64:
-    case Iop_MulF128:
-    case Iop_MulF32:
-    case Iop_MulF64r32:
-      if ((clientArgs[0] == 0 && !isNaN(args[1]->real)) ||
-          (clientArgs[1] == 0 && !isNaN(args[0]->real))){
-        if (print_influences){
-          if (clientArgs[0] == 0 && !isNaN(args[1]->real)){
-            VG_(printf)("Not propagating influences because arg 0 is zero (client val ");
-            ppFloat(clientArgs[0]);
-            VG_(printf)(")\n");
-          } else {
-            VG_(printf)("Not propagating influences because arg 1 is zero (client val ");
-            ppFloat(clientArgs[1]);
-            VG_(printf)(")\n");
-          }
-        }
-        ShadowValue* result =
-          mkShadowValue(argPrecision, clientResult);
-        if (use_ranges){
-          updateRanges(opinfo->agg.inputs.range_records, clientArgs, nargs);
-        }
-        execSymbolicOp(opinfo, &(result->expr), clientResult, args, False);
-        return result;
+  ValueType argPrecision = opinfo->desc->argPrecision;
+  int nargs = opinfo->desc->nargs;
+  for(int i = 0; i < nargs; ++i){
+    materializeShadowValue(args[i]);
+  }
+  if (isPureZeroMultiply(opinfo, args, clientArgs)){
+    if (print_influences){
+      if (clientArgs[0] == 0 && !isNaN(args[1]->real)){
+        VG_(printf)("Not propagating influences because arg 0 is zero (client val ");
+        ppFloat(clientArgs[0]);
+        VG_(printf)(")\n");
+      } else {
+        VG_(printf)("Not propagating influences because arg 1 is zero (client val ");
+        ppFloat(clientArgs[1]);
+        VG_(printf)(")\n");
       }
-      break;
-    default:
-      break;
     }
+    ShadowValue* result =
+      mkShadowValue(argPrecision, clientResult);
+    if (use_ranges){
+      updateRanges(opinfo->agg.inputs.range_records, clientArgs, nargs);
+    }
+    execSymbolicOp(opinfo, &(result->cold->expr), clientResult, args, False);
+    return result;
   }
   if (print_inputs){
     for(int i = 0; i < nargs; ++i){
@@ -261,8 +545,24 @@ ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
       VG_(printf)("\n");
     }
   }
+  Bool exact = !no_reals &&
+    isExactOp(opinfo->op_code, clientArgs, clientResult) &&
+    argsMatchClient(args, clientArgs, nargs);
   ShadowValue* result = mkShadowValueBare(argPrecision);
-  execRealOp(opinfo->op_code, &(result->real), args);
+  if (exact){
+    // The client got the real answer, so the shadow is just the
+    // client value, with no error.
+    setReal(result->real, clientResult);
+    numExactShadowOps++;
+  } else {
+    if (adaptivePrecision()){
+      setRealPrecision(result->real, opinfo->precision);
+    }
+    execRealOp(opinfo->op_code, &(result->real), args);
+    if (adaptivePrecision()){
+      adaptPrecision(opinfo, result, args, nargs);
+    }
+  }
   if (use_ranges){
     updateRanges(opinfo->agg.inputs.range_records, clientArgs, nargs);
   }
@@ -274,18 +574,20 @@ ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
   if (print_errors_long || print_errors){
     VG_(printf)("Local:\n");
   }
-  double bitsLocalError =
+  double bitsLocalError = exact ?
+    recordExactEval(&(opinfo->agg.local_error)) :
     execLocalOp(opinfo, result->real, result, args);
   if (print_errors_long || print_errors){
     VG_(printf)("Global:\n");
   }
-  double bitsGlobalError =
+  double bitsGlobalError = exact ?
+    recordExactEval(&(opinfo->agg.global_error)) :
     updateError(&(opinfo->agg.global_error), result->real, clientResult);
-  execSymbolicOp(opinfo, &(result->expr), clientResult, args,
+  execSymbolicOp(opinfo, &(result->cold->expr), clientResult, args,
                  bitsGlobalError > error_threshold);
   if (print_expr_refs){
     VG_(printf)("Making new expression %p for value %p with 1 references.\n",
-                result->expr, result);
+                result->cold->expr, result);
   }
   if (print_semantic_ops){
     VG_(printf)("%p = ", result);
@@ -305,57 +607,104 @@ ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
       VG_(printf)(")\n");
     }
   }
-  if (compensation_detection && !no_reals){
-    switch((int)opinfo->op_code){
-    case Iop_Add32F0x4:
-    case Iop_Add64F0x2:
-    case Iop_AddF64:
-    case Iop_AddF32:
-      if (getDouble(args[0]->real) == 0){
-        ULong inputError = ulpd(getDouble(args[1]->real), clientArgs[1]);
-        ULong outputError = ulpd(getDouble(result->real), clientResult);
-        if (outputError <= inputError){
-          result->influences = cloneInfluences(args[1]->influences);
-          return result;
-        }
-      }
-      // Intentional overflow to the next set of cases: both adds and
-      // subtracts are considered compensating if their second
-      // argument is zero in the reals (and the error decreases), but
-      // only adds also are compensating if their first argument is
-      // zero in the reals.
-    case Iop_Sub32F0x4:
-    case Iop_Sub64F0x2:
-    case Iop_SubF64:
-    case Iop_SubF32:
-      if (getDouble(args[1]->real) == 0){
-        ULong inputError = ulpd(getDouble(args[0]->real), clientArgs[0]);
-        ULong outputError = ulpd(getDouble(result->real), clientResult);
-        if (outputError <= inputError){
-          result->influences = cloneInfluences(args[0]->influences);
-          return result;
-        }
-      }
-      break;
-    default:
-      break;
+  propagateInfluences(opinfo, result, args, clientArgs, clientResult,
+                      bitsLocalError);
+  return result;
+}
+
+// Whether the lanes of a SIMD op can be run together by
+// executeLaneShadowOps. The options below all want to print or adjust
+// something between the steps of each lane, so they get the lanes
+// one at a time instead.
+static Bool canBatchLanes(void){
+  return !no_batch_lanes && !no_reals && !adaptivePrecision() &&
+    !print_inputs && !print_errors && !print_errors_long &&
+    !print_semantic_ops && !print_expr_refs && !print_influences;
+}
+// Runs all the lanes of a SIMD op on the same op info. This is the
+// same as running executeChannelShadowOp on each lane, but the
+// results are allocated together, the real ops run back to back,
+// and the op's ranges and error aggregates are updated once for the
+// whole instruction instead of once per lane.
+static void executeLaneShadowOps(ShadowOpInfo* opinfo, int numLanes,
+                                 ShadowValue* args[][4],
+                                 double clientArgs[][4],
+                                 double* clientResults,
+                                 ShadowValue** results){
+  int nargs = opinfo->desc->nargs;
+  // Lanes where a multiply gets a zero go the normal way, since they
+  // skip most of this.
+  int lanes[MAX_TEMP_BLOCKS];
+  int numBatched = 0;
+  for(int lane = 0; lane < numLanes; ++lane){
+    for(int i = 0; i < nargs; ++i){
+      materializeShadowValue(args[lane][i]);
+    }
+    if (isPureZeroMultiply(opinfo, args[lane], clientArgs[lane])){
+      results[lane] = executeChannelShadowOp(opinfo, args[lane],
+                                             clientArgs[lane],
+                                             clientResults[lane]);
+    } else {
+      lanes[numBatched++] = lane;
     }
   }
-  execInfluencesOp(opinfo, &(result->influences), args,
-                   bitsLocalError >= error_threshold);
-  if (print_influences){
-    VG_(printf)("Propagating influences for op ");
-    printOpInfo(opinfo);
-    VG_(printf)(":\n");
+  if (numBatched == 0) return;
+
+  if (use_ranges){
+    RangeRecord laneRanges[4];
     for(int i = 0; i < nargs; ++i){
-      VG_(printf)("Arg %p has influences:\n", args[i]);
-      ppInfluences(args[i]->influences);
+      initRangeRecord(&(laneRanges[i]));
+      for(int j = 0; j < numBatched; ++j){
+        updateRangeRecord(&(laneRanges[i]), clientArgs[lanes[j]][i]);
+      }
+      mergeRangeRecord(&(opinfo->agg.inputs.range_records[i]),
+                       &(laneRanges[i]));
     }
-    VG_(printf)("Value %p gets influences:\n", result);
-    ppInfluences(result->influences);
-    VG_(printf)("\n");
   }
-  return result;
+
+  ShadowValue* batchResults[MAX_TEMP_BLOCKS];
+  mkShadowValuesBare(opinfo->desc->argPrecision, numBatched, batchResults);
+  Bool exact[MAX_TEMP_BLOCKS];
+  for(int j = 0; j < numBatched; ++j){
+    int lane = lanes[j];
+    ShadowValue* result = batchResults[j];
+    exact[j] =
+      isExactOp(opinfo->op_code, clientArgs[lane], clientResults[lane]) &&
+      argsMatchClient(args[lane], clientArgs[lane], nargs);
+    if (exact[j]){
+      setReal(result->real, clientResults[lane]);
+      numExactShadowOps++;
+    } else {
+      execRealOp(opinfo->op_code, &(result->real), args[lane]);
+    }
+  }
+
+  double localErrors[MAX_TEMP_BLOCKS];
+  double globalErrors[MAX_TEMP_BLOCKS];
+  for(int j = 0; j < numBatched; ++j){
+    int lane = lanes[j];
+    if (exact[j]){
+      localErrors[j] = 0.0;
+      globalErrors[j] = 0.0;
+    } else {
+      localErrors[j] =
+        localBitsError(opinfo, batchResults[j]->real, args[lane]);
+      globalErrors[j] =
+        bitsErrorOf(batchResults[j]->real, clientResults[lane]);
+    }
+  }
+  recordLaneErrors(&(opinfo->agg.local_error), localErrors, numBatched);
+  recordLaneErrors(&(opinfo->agg.global_error), globalErrors, numBatched);
+
+  for(int j = 0; j < numBatched; ++j){
+    int lane = lanes[j];
+    ShadowValue* result = batchResults[j];
+    execSymbolicOp(opinfo, &(result->cold->expr), clientResults[lane],
+                   args[lane], globalErrors[j] > error_threshold);
+    propagateInfluences(opinfo, result, args[lane], clientArgs[lane],
+                        clientResults[lane], localErrors[j]);
+    results[lane] = result;
+  }
 }
 
 FloatBlocks numOpArgBlocks(IROp_Extended op){
@@ -36,7 +36,37 @@
 #include "../value-shadowstate/shadowval.h"
 #include "../op-shadowstate/shadowop-info.h"
 
+// Scalar ops whose results only feed into one later scalar op in
+// the same block get run together, in one call, without making temps
+// for the values in between. This is the most ops that get run
+// together like that.
+#define MAX_FUSED_OPS 8
+
+typedef struct _FusedOp {
+  ShadowOpInfoInstance* instance;
+  // For each argument, the earlier op in the chain that computes it,
+  // or -1 if it comes from a temp or a constant.
+  int argOps[3];
+} FusedOp;
+
+// The ops are in the order they run, so the last one is the one
+// whose result comes out.
+typedef struct _FusedChain {
+  int numOps;
+  FusedOp ops[MAX_FUSED_OPS];
+} FusedChain;
+
+extern ULong numPrecisionEscalations;
+extern ULong numExactShadowOps;
+// The client arguments and result of each op in a fused chain, as
+// the bits of doubles, with the result last.
+extern UWord fusedClientValues[MAX_FUSED_OPS][4];
+
 VG_REGPARM(1) ShadowTemp* executeShadowOp(ShadowOpInfoInstance* instance);
+VG_REGPARM(3) ShadowTemp* executeScalarShadowOp(ShadowOpInfoInstance* instance,
+                                                UWord arg0, UWord arg1,
+                                                UWord arg2, UWord clientResult);
+VG_REGPARM(1) ShadowTemp* executeFusedShadowOps(FusedChain* chain);
 ShadowTemp* getArg(int argIdx, IROp op, IRTemp argTemp);
 ShadowValue* executeChannelShadowOp(ShadowOpInfo* opinfo,
                                     ShadowValue** args,
@@ -46,7 +46,7 @@ void execSymbolicOp(ShadowOpInfo* opinfo, ConcExpr** result,
   ConcExpr* exprArgs[MAX_BRANCH_ARGS];
   int nargs = numFloatArgs(opinfo);
   for(int i = 0; i < nargs; ++i){
-    exprArgs[i] = args[i]->expr;
+    exprArgs[i] = args[i]->cold->expr;
   }
   *result = mkBranchConcExpr(computedResult, opinfo,
                              nargs, exprArgs);
@@ -42,10 +42,6 @@
 #include <math.h>
 #include <inttypes.h>
 
-Stack* leafCExprs;
-Stack* branchCExprs[MAX_BRANCH_ARGS];
-Xarray_H(Stack*, StackArray);
-Xarray_Impl(Stack*, StackArray);
 Xarray_H(char*, VarList);
 Xarray_Impl(char*, VarList);
 
@@ -57,16 +53,17 @@ VarList extraVars;
 
 List_Impl(NodePos, Group);
 Xarray_Impl(Group, GroupList);
+// Branch expressions keep their argument array right after them in
+// the same slab object, so each arity gets its own size class.
+#define BRANCH_CEXPR_SIZE(nargs) \
+  (sizeof(ConcExpr) + sizeof(ConcExpr*) * (nargs))
+
 void initExprAllocator(void){
-  leafCExprs = mkStack();
-  for(int i = 0; i < MAX_BRANCH_ARGS; ++i){
-    branchCExprs[i] = mkStack();
-  }
   extraVars = mkXA(VarList)();
   initializePositionTree();
 }
 VG_REGPARM(1) void freeBranchConcExpr(ConcExpr* expr){
-  stack_push(branchCExprs[expr->branch.nargs - 1], (void*)expr);
+  slabFree(expr, BRANCH_CEXPR_SIZE(expr->branch.nargs));
 }
 void recursivelyDisownConcExpr(ConcExpr* expr, int depth){
   if (depth == 0) return;
@@ -83,7 +80,7 @@ void recursivelyDisownConcExpr(ConcExpr* expr, int depth){
       VG_(printf)("No references left for expr %p! Freeing...\n", expr);
     }
     if (expr->type == Node_Leaf){
-      stack_push(leafCExprs, (void*)expr);
+      slabFree(expr, sizeof(ConcExpr));
     } else {
       freeBranchConcExpr(expr);
     }
@@ -98,13 +95,8 @@ void disownConcExpr(ConcExpr* expr){
   recursivelyDisownConcExpr(expr, max_expr_block_depth * 2);
 }
 ConcExpr* mkLeafConcExpr(double value){
-  ConcExpr* result;
-  if (stack_empty(leafCExprs)){
-    result = VG_(malloc)("expr", sizeof(ConcExpr));
-    result->type = Node_Leaf;
-  } else {
-    result = (void*)stack_pop(leafCExprs);
-  }
+  ConcExpr* result = slabAlloc(sizeof(ConcExpr));
+  result->type = Node_Leaf;
   result->ref_count = 1;
   if (print_expr_refs){
     VG_(printf)("Making new expression %p with 1 reference\n", result);
@@ -131,16 +123,11 @@ void recursivelyOwnConcExpr(ConcExpr* expr, int depth){
 
 ConcExpr* mkBranchConcExpr(double value, ShadowOpInfo* op,
                            int nargs, ConcExpr** args){
-  ConcExpr* result;
-  if (stack_empty(branchCExprs[nargs-1])){
-    result = VG_(malloc)("expr", sizeof(ConcExpr));
-    result->branch.args = VG_(perm_malloc)(sizeof(ConcExpr*) * nargs,
-                                           vg_alignof(ConcExpr*));
-    result->branch.nargs = nargs;
-    result->type = Node_Branch;
-  } else {
-    result = (void*)stack_pop(branchCExprs[nargs-1]);
-  }
+  tl_assert(nargs <= MAX_BRANCH_ARGS);
+  ConcExpr* result = slabAlloc(BRANCH_CEXPR_SIZE(nargs));
+  result->branch.args = (ConcExpr**)(result + 1);
+  result->branch.nargs = nargs;
+  result->type = Node_Branch;
   // We'll do ownership stuff at the end, leave it at 0 refs for now.
   if (print_expr_refs){
     VG_(printf)("Making new expression %p with 0 references\n", result);
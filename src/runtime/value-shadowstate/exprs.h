@@ -39,6 +39,7 @@
 #include "../../helper/list.h"
 #include "../../helper/xarray.h"
 #include "../../helper/stack.h"
+#include "../../helper/slab.h"
 
 #include "pub_tool_basics.h"
 #include "pub_tool_hashtable.h"
@@ -63,8 +64,6 @@ struct _ConcExpr {
 List_H(NodePos, Group);
 Xarray_H(Group, GroupList);
 
-extern Stack* leafCExprs;
-
 struct _SymbExpr {
   NodeType type;
   double constVal;
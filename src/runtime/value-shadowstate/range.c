@@ -63,6 +63,22 @@ void updateRangeRecord(RangeRecord* range, double value){
   }
 }
 
+// Widens dest to cover everything in src.
+void mergeRangeRecord(RangeRecord* dest, RangeRecord* src){
+  if (dest->pos_range.min > src->pos_range.min){
+    dest->pos_range.min = src->pos_range.min;
+  }
+  if (dest->pos_range.max < src->pos_range.max){
+    dest->pos_range.max = src->pos_range.max;
+  }
+  if (dest->neg_range.min > src->neg_range.min){
+    dest->neg_range.min = src->neg_range.min;
+  }
+  if (dest->neg_range.max < src->neg_range.max){
+    dest->neg_range.max = src->neg_range.max;
+  }
+}
+
 RangeRecord* copyRangeRecord(RangeRecord* record){
   RangeRecord* result = VG_(malloc)("range record", sizeof(RangeRecord));
   copyRangeRecordInPlace(result, record);
@@ -47,6 +47,7 @@ void initRangeRecord(RangeRecord* record);
 void initRange(Range* range);
 RangeRecord* copyRangeRecord(RangeRecord* record);
 void copyRangeRecordInPlace(RangeRecord* dest, RangeRecord* src);
+void mergeRangeRecord(RangeRecord* dest, RangeRecord* src);
 int nonTrivialRange(RangeRecord* range);
 void printRangeAsPreconditionToBBuf(const char* varName,
                                     RangeRecord* totalRange,
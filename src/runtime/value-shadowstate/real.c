@@ -34,15 +34,114 @@
 #include "pub_tool_libcassert.h"
 
 Real mkReal(void){
-  Real result = VG_(malloc)("real", sizeof(struct _RealStruct));
+  Real result = VG_(malloc)("real", realSize());
+  initRealAt(result);
+  return result;
+}
+// The most bits any real will be asked to hold. Reals keep their
+// limbs right after the struct, with room for this many bits, so
+// changing a real's precision never has to reallocate anything.
+Int maxRealPrecision(void){
+  if (real_type != Rt_MPFR){
+    return realPrecision();
+  }
+  return precision;
+}
+// How many bytes a real takes up, limbs included.
+SizeT realSize(void){
   #ifdef USE_MPFR
-  mpfr_init2(result->mpfr_val, precision);
+  return sizeof(struct _RealStruct) +
+    mpfr_custom_get_size(maxRealPrecision());
   #else
-  mpf_init2(result->mpf_val, precision);
+  return sizeof(struct _RealStruct);
+  #endif
+}
+// Set up a real in realSize() bytes of memory that someone else
+// allocated.
+void initRealAt(Real real){
+  #ifdef USE_MPFR
+  void* limbs = ((char*)real) + sizeof(struct _RealStruct);
+  mpfr_custom_init(limbs, maxRealPrecision());
+  mpfr_custom_init_set(real->mpfr_val, MPFR_ZERO_KIND, 0,
+                       realPrecision(), limbs);
+  #else
+  mpf_init2(real->mpf_val, realPrecision());
+  #endif
+}
+Int realPrecision(void){
+  switch(real_type){
+  case Rt_DoubleDouble:
+    return 106;
+  case Rt_TripleDouble:
+    return 159;
+  default:
+    if (adaptivePrecision()){
+      return start_precision;
+    }
+    return precision;
+  }
+}
+// Change the precision a real is stored at. This clobbers the
+// value, so only do it to reals you're about to write.
+void setRealPrecision(Real real, Int bits){
+  #ifdef USE_MPFR
+  if (mpfr_get_prec(real->mpfr_val) != bits){
+    tl_assert(bits <= maxRealPrecision());
+    mpfr_custom_init_set(real->mpfr_val, MPFR_NAN_KIND, 0, bits,
+                         mpfr_custom_get_significand(real->mpfr_val));
+  }
+  #else
+  mpf_set_prec(real->mpf_val, bits);
+  #endif
+}
+// Before using an MPFR function on a double-double or triple-double
+// real, call this to set its mpfr_val from the parts. Does nothing
+// for MPFR reals.
+void syncRealToMPFR(Real real){
+  if (real_type == Rt_MPFR) return;
+  #ifdef USE_MPFR
+  mpfr_set_d(real->mpfr_val, real->parts[0], MPFR_RNDN);
+  for(int i = 1; i < numRealParts(); ++i){
+    mpfr_add_d(real->mpfr_val, real->mpfr_val, real->parts[i], MPFR_RNDN);
+  }
+  #else
+  tl_assert2(0, "Double-double reals need MPFR!\n");
+  #endif
+}
+// And after an MPFR function sets the mpfr_val of one, call this to
+// split it back up into parts.
+void syncRealFromMPFR(Real real){
+  if (real_type == Rt_MPFR) return;
+  #ifdef USE_MPFR
+  static mpfr_t remainder;
+  static Bool remainderInitialized = False;
+  if (!remainderInitialized){
+    mpfr_init2(remainder, realPrecision());
+    remainderInitialized = True;
+  }
+  mpfr_set(remainder, real->mpfr_val, MPFR_RNDN);
+  for(int i = 0; i < MAX_REAL_PARTS; ++i){
+    if (i < numRealParts()){
+      real->parts[i] = mpfr_get_d(remainder, MPFR_RNDN);
+      mpfr_sub_d(remainder, remainder, real->parts[i], MPFR_RNDN);
+    } else {
+      real->parts[i] = 0.0;
+    }
+  }
+  // Infinities and NaNs don't split.
+  if (real->parts[0] - real->parts[0] != 0.0){
+    real->parts[1] = 0.0;
+    real->parts[2] = 0.0;
+  }
+  #else
+  tl_assert2(0, "Double-double reals need MPFR!\n");
   #endif
-  return result;
 }
 void setReal(Real r, double bytes){
+  if (real_type != Rt_MPFR){
+    setReal_fast(r, bytes);
+    return;
+  }
   #ifdef USE_MPFR
   mpfr_set_d(r->mpfr_val, bytes, MPFR_RNDN);
   #else
@@ -50,9 +149,9 @@ void setReal(Real r, double bytes){
   #endif
 }
 void freeReal(Real real){
-  #ifdef USE_MPFR
-  mpfr_clear(real->mpfr_val);
-  #else
+  // With MPFR the limbs are part of the same allocation, so there's
+  // nothing to clear.
+  #ifndef USE_MPFR
   mpf_clear(real->mpf_val);
   #endif
   VG_(free)(real);
@@ -60,6 +159,9 @@ void freeReal(Real real){
 
 double getDouble(Real real){
   if (no_reals) return 0.0;
+  // The parts are kept normalized, so the first one is the whole
+  // value rounded to a double.
+  if (real_type != Rt_MPFR) return real->parts[0];
   #ifdef USE_MPFR
   return mpfr_get_d(real->mpfr_val, MPFR_RNDN);
   #else
@@ -69,6 +171,7 @@ double getDouble(Real real){
 
 int isNaN(Real real){
   if (no_reals) return 0;
+  if (real_type != Rt_MPFR) return real->parts[0] != real->parts[0];
   #ifdef USE_MPFR
   return mpfr_nan_p(real->mpfr_val);
   #else
@@ -76,6 +179,13 @@ int isNaN(Real real){
   #endif
 }
 int realCompare(Real real1, Real real2){
+  if (real_type != Rt_MPFR){
+    for(int i = 0; i < numRealParts(); ++i){
+      if (real1->parts[i] < real2->parts[i]) return -1;
+      if (real1->parts[i] > real2->parts[i]) return 1;
+    }
+    return 0;
+  }
   #ifdef USE_MPFR
   return mpfr_cmp(real1->mpfr_val, real2->mpfr_val);
   #else
@@ -83,8 +193,32 @@ int realCompare(Real real1, Real real2){
   #endif
 }
 
+// Whether the real is exactly this double, with nothing left over in
+// the lower bits.
+Bool realEqualsDouble(Real real, double value){
+  if (value != value) return False;
+  if (real_type != Rt_MPFR){
+    for(int i = 1; i < numRealParts(); ++i){
+      if (real->parts[i] != 0.0) return False;
+    }
+    return real->parts[0] == value;
+  }
+  #ifdef USE_MPFR
+  return !mpfr_nan_p(real->mpfr_val) &&
+    mpfr_cmp_d(real->mpfr_val, value) == 0;
+  #else
+  return mpf_cmp_d(real->mpf_val, value) == 0;
+  #endif
+}
 void copyReal(Real src, Real dest){
+  if (real_type != Rt_MPFR){
+    for(int i = 0; i < MAX_REAL_PARTS; ++i){
+      dest->parts[i] = src->parts[i];
+    }
+    return;
+  }
   #ifdef USE_MPFR
+  setRealPrecision(dest, mpfr_get_prec(src->mpfr_val));
   mpfr_set(dest->mpfr_val, src->mpfr_val, MPFR_RNDN);
   #else
   mpf_set(dest->mpf_val, src->mpf_val);
@@ -96,6 +230,7 @@ void printReal(Real real){
   char* shadowValStr;
   mpfr_exp_t shadowValExpt;
 
+  syncRealToMPFR(real);
   shadowValStr = mpfr_get_str(NULL, &shadowValExpt, 10, longprint_len, real->mpfr_val, MPFR_RNDN);
   VG_(printf)("%c.%se%ld", shadowValStr[0], shadowValStr+1, shadowValExpt-1);
   mpfr_free_str(shadowValStr);
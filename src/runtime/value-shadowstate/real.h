@@ -40,31 +40,66 @@
 
 #include "pub_tool_basics.h"
 
+#define MAX_REAL_PARTS 3
+
 typedef struct _RealStruct{
   #ifdef USE_MPFR
   mpfr_t mpfr_val;
   #else
   mpf_t mpf_val;
   #endif
+  // With --real-type=double-double or triple-double, the value is
+  // the unevaluated sum of these, biggest first, and mpfr_val is just
+  // used to hand it to MPFR for ops we can't do on the parts.
+  double parts[MAX_REAL_PARTS];
 } *Real;
 
 Real mkReal(void);
+Int realPrecision(void);
+Int maxRealPrecision(void);
+SizeT realSize(void);
+void initRealAt(Real real);
+void setRealPrecision(Real real, Int bits);
+void syncRealToMPFR(Real real);
+void syncRealFromMPFR(Real real);
 void setReal(Real r, double bytes);
 
 double getDouble(Real real);
 int isNaN(Real real);
 int realCompare(Real real1, Real real2);
+Bool realEqualsDouble(Real real, double value);
 
 void freeReal(Real real);
 void copyReal(Real src, Real dest);
 void printReal(Real real);
 
+inline int numRealParts(void);
+inline Bool adaptivePrecision(void);
 inline void setReal_fast(Real r, double bytes);
 
+__attribute__((always_inline))
+inline
+int numRealParts(void){
+  return real_type == Rt_TripleDouble ? 3 : 2;
+}
+// With --start-precision, MPFR reals don't all have the same
+// precision; each op site picks its own, and raises it as needed.
+__attribute__((always_inline))
+inline
+Bool adaptivePrecision(void){
+  return real_type == Rt_MPFR &&
+    start_precision > 0 && start_precision < precision;
+}
 __attribute__((always_inline))
 inline
 void setReal_fast(Real r, double bytes){
   if (no_reals) return;
+  if (real_type != Rt_MPFR){
+    r->parts[0] = bytes;
+    r->parts[1] = 0.0;
+    r->parts[2] = 0.0;
+    return;
+  }
   #ifdef USE_MPFR
   mpfr_set_d(r->mpfr_val, bytes, MPFR_RNDN);
   #else
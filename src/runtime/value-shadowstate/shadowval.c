@@ -30,6 +30,7 @@
 #include "shadowval.h"
 #include "exprs.h"
 #include "real.h"
+#include "../../helper/slab.h"
 
 #include "pub_tool_mallocfree.h"
 #include "pub_tool_hashtable.h"
@@ -38,11 +39,10 @@
 #include "pub_tool_libcassert.h"
 
 VG_REGPARM(1) ShadowTemp* newShadowTemp(FloatBlocks num_blocks){
-  ShadowTemp* newShadowTemp =
-    VG_(perm_malloc)(sizeof(ShadowTemp), vg_alignof(ShadowTemp));
+  ShadowTemp* newShadowTemp = slabAlloc(sizeof(ShadowTemp));
   newShadowTemp->num_blocks = num_blocks;
   newShadowTemp->values =
-    VG_(perm_malloc)(INT(num_blocks) * sizeof(ShadowValue*), vg_alignof(ShadowValue*));
+    slabAlloc(INT(num_blocks) * sizeof(ShadowValue*));
   return newShadowTemp;
 }
 void changeSingleValueType(ShadowTemp* temp, ValueType type){
@@ -55,14 +55,43 @@ UWord hashDouble(double val){
   VG_(memcpy)(&result, &val, sizeof(UWord));
   return result;
 }
+// Each shadow value is a small header from its own slab class, so
+// that the headers sit densely together instead of between the
+// temps and table entries that share their size, plus one side record
+// holding the cold fields, then the real, then the real's limbs,
+// padded out to a cache line.
+static SizeT recordSize = 0;
+SlabClass shadowValueHeaders = SLAB_CLASS_INIT(sizeof(ShadowValue));
+
+SizeT shadowValueRecordSize(void){
+  if (recordSize == 0){
+    SizeT size = sizeof(ShadowValueCold);
+    if (!no_reals){
+      size += realSize();
+    }
+    recordSize = VG_ROUNDUP(size, SLAB_CHUNK_ALIGN);
+  }
+  return recordSize;
+}
 inline
 ShadowValue* newShadowValue(ValueType type){
-  ShadowValue* result =
-    VG_(perm_malloc)(sizeof(ShadowValue), vg_alignof(ShadowValue));
+  // Headers get reused without being cleared, so we can't count on
+  // anything being left over from the last value that was here.
+  ShadowValue* result = slabClassAlloc_fast(&shadowValueHeaders);
   result->type = type;
   result->ref_count = 1;
-  if (!no_reals){
-    result->real = mkReal();
+  result->cold = slabAlloc_fast(shadowValueRecordSize());
+  result->cold->expr = NULL;
+  result->cold->influences = NULL;
+  result->interned = False;
+  result->lazy = False;
+  result->freePending = False;
+  result->marked = False;
+  if (no_reals){
+    result->real = NULL;
+  } else {
+    result->real = (Real)(result->cold + 1);
+    initRealAt(result->real);
   }
   return result;
 }
@@ -36,18 +36,37 @@
 #include "real.h"
 #include "../../instrument/floattypes.h"
 #include "../../helper/list.h"
+#include "../../helper/slab.h"
 #include "../op-shadowstate/shadowop-info.h"
 #include "influence-list.h"
 
-typedef struct _ShadowValue {
-  // For the various data structures that will hold these values.
-  struct _ShadowValue* next;
+// The parts of a shadow value that only the analyses look at. These
+// live in a side record, so that the headers the ops and the
+// ownership code touch stay packed together.
+typedef struct _ShadowValueCold {
+  ConcExpr* expr;
+  InfluenceList influences;
+  // Lazy leaves don't have a real or an expression yet, just the
+  // client value they were made from. See mkLazyShadowValue.
+  double leafValue;
+} ShadowValueCold;
 
+typedef struct _ShadowValue {
+  // The instrumentation bumps this inline, so it has to stay a full
+  // word at a fixed offset.
   UWord ref_count;
   Real real;
-  ConcExpr* expr;
-  InfluenceList influences;
+  ShadowValueCold* cold;
   ValueType type;
+  // Whether this is a leaf value in the intern table, which has to
+  // come out when it's freed.
+  Bool interned;
+  Bool lazy;
+  // Whether this is sitting in the deferred free buffer. See
+  // deferFreeShadowValue.
+  Bool freePending;
+  // Set while --shadow-gc=mark-sweep is marking.
+  Bool marked;
 } ShadowValue;
 
 typedef struct _ShadowTemp {
@@ -65,6 +84,8 @@ void changeSingleValueType(ShadowTemp* temp, ValueType type);
 
 UWord hashDouble(double val);
 ShadowValue* newShadowValue(ValueType type);
+SizeT shadowValueRecordSize(void);
+extern SlabClass shadowValueHeaders;
 void updateRanges(RangeRecord* records, double* args, int nargs);
 VG_REGPARM(2) void assertValValid(const char* label, ShadowValue* val);
 VG_REGPARM(2) void assertTempValid(const char* label, ShadowTemp* temp);
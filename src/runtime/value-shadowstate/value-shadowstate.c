@@ -46,29 +46,75 @@
 
 int blockStateDirty = 0;
 
+ShadowValue* deferredFrees[MAX_DEFERRED_FREES];
+UWord numDeferredFrees = 0;
+ULong numDeferredFreesApplied = 0;
+ULong numDeferredFreesRescued = 0;
+
+ShadowValue** gcValues = NULL;
+UWord numGCValues = 0;
+UWord gcValuesCapacity = 0;
+UWord gcAllocsUntilCollect = MIN_GC_INTERVAL;
+UWord gcPending = 0;
+ULong numCollections = 0;
+ULong numCollectedValues = 0;
+
 ArgUnion computedArgs;
 
 ResultUnion computedResult;
 
 ShadowTemp* shadowTemps[MAX_TEMPS];
-ShadowValue* shadowThreadState[MAX_THREADS][MAX_REGISTERS];
-TableValueEntry* shadowMemTable[LARGE_PRIME];
+ShadowValue*** shadowThreadState;
+ShadowValue** curThreadState = NULL;
+SecondaryMap* primaryMap[N_PRIMARY_MAP];
+SecondaryMap emptySecondaryMap;
+TableValueEntry* auxMemTable[AUX_TABLE_SIZE];
+UWord numAuxMemEntries = 0;
+UWord shadowPageBitmap[SHADOW_PAGE_BITMAP_WORDS];
+// How many memory blocks (slot halves, or aligned doubles, plus
+// auxiliary entries) are shadowed right now, for checking against
+// --shadow-memory-limit.
+UWord numMemShadows = 0;
+ULong numEvictedMemShadows = 0;
+ULong numInlineMemChecks = 0;
+ULong numInlineMemChecksToC = 0;
+ULong numDynamicLoads = 0;
+ULong numSetMemShadowTemps = 0;
+
+static SecondaryMap* allocatedSecondaries = NULL;
+static UWord numSecondaryMaps = 0;
+static ULong memShadowClock = 0;
 
 Stack* freedTemps[MAX_TEMP_BLOCKS];
-Stack* freedVals;
-Stack* tableEntries;
 
 Word256 getBytes;
 inline TableValueEntry* mkTableEntry(void);
+SecondaryMap* getSecondaryMapForWriting(Addr64 addr);
+void markShadowPage(Addr64 addr);
+void unmarkShadowPage(Addr64 addr);
+ShadowValue* swapSlotHalf(UWord* slot, int half, ShadowValue* val);
+void clearMemShadowSlot(SecondaryMap* secondary, Addr64 addr);
+void setMemShadowDouble(Addr64 addr, ShadowValue* val);
+void removeAuxMemShadow(Addr64 addr);
+void addAuxMemShadow(Addr64 addr, ShadowValue* val);
+void clearAuxMemShadowRange(Addr64 start, SizeT len);
+void copyOverlappingMemShadowRange(Addr64 dest, Addr64 src, SizeT len);
+SizeT estimateMemShadowBytes(void);
+void evictMemShadows(SizeT targetBytes);
+void freeSecondaryMap(SecondaryMap* secondary);
+static ShadowValue* newLazyLeaf(ValueType type, double value);
 
 void initValueShadowState(void){
+  for(UWord i = 0; i < N_PRIMARY_MAP; ++i){
+    primaryMap[i] = &emptySecondaryMap;
+  }
+  shadowThreadState =
+    VG_(calloc)("shadowThreadState", VG_N_THREADS, sizeof(ShadowValue**));
   for(int i = 0; i < MAX_TEMP_BLOCKS; ++i){
     freedTemps[i] = mkStack();
   }
-  freedVals = mkStack();
-  tableEntries = mkStack();
-  valueCacheSingle = VG_(HT_construct)("value cache single-precision");
-  valueCacheDouble = VG_(HT_construct)("value cache double precision");
+  internTable =
+    VG_(calloc)("intern table", INTERN_TABLE_SIZE, sizeof(InternEntry));
   initExprAllocator();
 }
 
@@ -107,11 +153,43 @@ VG_REGPARM(2) void dynamicCleanup(int nentries, IRTemp* entries){
     freeShadowTemp(temp);
     shadowTemps[entries[i]] = NULL;
   }
+  flushDeferredFrees();
   blockStateDirty = 0;
 }
+// Valgrind doesn't tell us about the main thread being created, so
+// we also make thread states here, the first time a thread runs.
+void shadowThreadCreate(ThreadId parent, ThreadId child){
+  tl_assert(child < VG_N_THREADS);
+  if (shadowThreadState[child] == NULL){
+    shadowThreadState[child] =
+      VG_(calloc)("threadState", MAX_REGISTERS, sizeof(ShadowValue*));
+  }
+}
+void shadowThreadExit(ThreadId tid){
+  ShadowValue** threadState = shadowThreadState[tid];
+  if (threadState == NULL){
+    return;
+  }
+  for(int i = 0; i < MAX_REGISTERS; ++i){
+    disownShadowValue(threadState[i]);
+  }
+  VG_(free)(threadState);
+  shadowThreadState[tid] = NULL;
+  if (curThreadState == threadState){
+    curThreadState = NULL;
+  }
+}
+// Called whenever Valgrind is about to run client code on a thread,
+// which is the only time the running thread can change. Shadow temps
+// don't need switching, since they never outlive the superblock they
+// were made in.
+void shadowThreadRun(ThreadId tid, ULong blocksDone){
+  shadowThreadCreate(VG_INVALID_THREADID, tid);
+  curThreadState = shadowThreadState[tid];
+}
 inline
 ShadowValue* getTS(Int idx){
-  ShadowValue* result = shadowThreadState[VG_(get_running_tid)()][idx];
+  ShadowValue* result = curThreadState[idx];
   tl_assert2(result == NULL || result->ref_count > 0,
              "Freed value %p left over at TS(%d)",
              result, idx);
@@ -120,8 +198,28 @@ ShadowValue* getTS(Int idx){
 VG_REGPARM(2) ShadowTemp* dynamicLoad(Addr memSrc, FloatBlocks numBlocks){
   ShadowValue* values[MAX_TEMP_BLOCKS];
   Bool atLeastOneNonNull = False;
+  numDynamicLoads++;
   for(int i = 0; i < INT(numBlocks); ++i){
-    values[i] = getMemShadow(memSrc + i * sizeof(float));
+    Addr addr = memSrc + i * sizeof(float);
+    // If this block and the next share a slot, read them both at
+    // once.
+    if (i + 1 < INT(numBlocks) &&
+        addr % sizeof(double) == 0 && inPrimaryMap(addr)){
+      UWord slot = *getMemShadowSlot(addr);
+      values[i] = slotHalf(slot, 0);
+      values[i + 1] = slotHalf(slot, 1);
+      if (slot != 0){
+        primaryMap[addr >> SM_BITS]->lastTouched = ++memShadowClock;
+      }
+      atLeastOneNonNull =
+        atLeastOneNonNull || values[i] != NULL || values[i + 1] != NULL;
+      ++i;
+      continue;
+    }
+    values[i] = getMemShadow(addr);
+    if (values[i] != NULL && addr <= MAX_PRIMARY_ADDRESS){
+      primaryMap[addr >> SM_BITS]->lastTouched = ++memShadowClock;
+    }
     atLeastOneNonNull = atLeastOneNonNull || values[i] != NULL;
   }
   if (atLeastOneNonNull){
@@ -147,10 +245,14 @@ VG_REGPARM(2) ShadowTemp* dynamicLoad(Addr memSrc, FloatBlocks numBlocks){
   }
 }
 VG_REGPARM(1) ShadowValue* getMemShadow(Addr64 addr){
-  int key = addr % LARGE_PRIME;
-  for(TableValueEntry* node = shadowMemTable[key];
+  if (inPrimaryMap(addr)){
+    return slotHalf(*getMemShadowSlot(addr), SLOT_HALF(addr));
+  }
+  int key = addr % AUX_TABLE_SIZE;
+  for(TableValueEntry* node = auxMemTable[key];
       node != NULL; node = node->next){
     if (node->addr == addr){
+      node->lastTouched = ++memShadowClock;
       return node->val;
     }
   }
@@ -159,22 +261,180 @@ VG_REGPARM(1) ShadowValue* getMemShadow(Addr64 addr){
 VG_REGPARM(3) void setMemShadowTemp(Addr64 memDest,
                                     UWord size,
                                     ShadowTemp* st){
+  numSetMemShadowTemps++;
   for(int i = 0; i < size; ++i){
     UWord addr = memDest + i * sizeof(float);
+    ShadowValue* val = st == NULL ? NULL : st->values[i];
+    // An aligned double fills a whole slot by itself, so we can set
+    // it in one go.
+    if (val != NULL && val->type == Vt_Double &&
+        i + 1 < size && st->values[i + 1] == NULL &&
+        addr % sizeof(double) == 0 && inPrimaryMap(addr)){
+      setMemShadowDouble(addr, val);
+      ++i;
+      continue;
+    }
     removeMemShadow(addr);
-    if (st != NULL && st->values[i] != NULL){
-      addMemShadow(addr, st->values[i]);
+    if (val != NULL){
+      addMemShadow(addr, val);
+    }
+  }
+  maybeEvictMemShadows();
+}
+void setMemShadowDouble(Addr64 addr, ShadowValue* val){
+  SecondaryMap* secondary = getSecondaryMapForWriting(addr);
+  UWord* slot = &(secondary->slots[(addr & SM_MASK) / sizeof(double)]);
+  ShadowValue* oldHalves[2] = {slotHalf(*slot, 0), slotHalf(*slot, 1)};
+  if (SLOT_IS_SPLIT(*slot)){
+    slabFree(SLOT_SPLIT(*slot), sizeof(SplitSlot));
+  }
+  ownShadowValue(val);
+  *slot = (UWord)val;
+  secondary->numLive++;
+  secondary->lastTouched = ++memShadowClock;
+  numMemShadows++;
+  markShadowPage(addr);
+  if (PRINT_VALUE_MOVES){
+    VG_(printf)("Setting %llX to %p (new rc %lu)\n",
+                addr, val, val->ref_count);
+  }
+  for(int i = 0; i < 2; ++i){
+    if (oldHalves[i] != NULL){
+      if (PRINT_VALUE_MOVES){
+        VG_(printf)("Clearing %llX, which disowns %p (old rc %lu)\n",
+                    addr + i * sizeof(float), oldHalves[i],
+                    oldHalves[i]->ref_count);
+      }
+      secondary->numLive--;
+      numMemShadows--;
+      unmarkShadowPage(addr);
+      disownShadowValue(oldHalves[i]);
+    }
+  }
+}
+SecondaryMap* getSecondaryMapForWriting(Addr64 addr){
+  SecondaryMap** primaryEntry = &(primaryMap[addr >> SM_BITS]);
+  if (*primaryEntry == &emptySecondaryMap){
+    *primaryEntry = VG_(malloc)("secondaryMap", sizeof(SecondaryMap));
+    VG_(memset)(*primaryEntry, 0, sizeof(SecondaryMap));
+    (*primaryEntry)->base = addr & ~((Addr64)SM_MASK);
+    (*primaryEntry)->next = allocatedSecondaries;
+    if (allocatedSecondaries != NULL){
+      allocatedSecondaries->prev = *primaryEntry;
+    }
+    allocatedSecondaries = *primaryEntry;
+    numSecondaryMaps++;
+    if (print_allocs){
+      VG_(printf)("Allocated secondary map %p for %llX\n",
+                  *primaryEntry, addr & ~((Addr64)SM_MASK));
     }
   }
+  return *primaryEntry;
+}
+// Only for addresses covered by the primary map.
+void markShadowPage(Addr64 addr){
+  SecondaryMap* secondary = getSecondaryMapForWriting(addr);
+  UShort* pageCount = &(secondary->pageLive[(addr & SM_MASK) >> SHADOW_PAGE_BITS]);
+  if (*pageCount == 0){
+    UWord page = addr >> SHADOW_PAGE_BITS;
+    shadowPageBitmap[page / (8 * sizeof(UWord))] |=
+      ((UWord)1) << (page % (8 * sizeof(UWord)));
+  }
+  (*pageCount)++;
+}
+void unmarkShadowPage(Addr64 addr){
+  SecondaryMap* secondary = primaryMap[addr >> SM_BITS];
+  UShort* pageCount = &(secondary->pageLive[(addr & SM_MASK) >> SHADOW_PAGE_BITS]);
+  tl_assert(*pageCount > 0);
+  (*pageCount)--;
+  if (*pageCount == 0){
+    UWord page = addr >> SHADOW_PAGE_BITS;
+    shadowPageBitmap[page / (8 * sizeof(UWord))] &=
+      ~(((UWord)1) << (page % (8 * sizeof(UWord))));
+  }
+}
+// Whether anything in the page holding addr is shadowed, including
+// auxiliary entries. Only for addresses covered by the primary map.
+static Bool shadowPageMarked(Addr64 addr){
+  UWord page = addr >> SHADOW_PAGE_BITS;
+  return (shadowPageBitmap[page / (8 * sizeof(UWord))] >>
+          (page % (8 * sizeof(UWord)))) & 1;
+}
+// Whether the page holding addr has any auxiliary entries. Only for
+// addresses covered by the primary map.
+static Bool pageHasAuxEntries(Addr64 addr){
+  return primaryMap[addr >> SM_BITS]->
+    pageAux[(addr & SM_MASK) >> SHADOW_PAGE_BITS] > 0;
+}
+// Whether any page overlapping [start, start + len) is marked. Only
+// for ranges covered by the primary map.
+static Bool anyShadowPageMarked(Addr64 start, SizeT len){
+  for(Addr64 page = start & ~((Addr64)SHADOW_PAGE_MASK);
+      page < start + len; page += SHADOW_PAGE_SIZE){
+    if (shadowPageMarked(page)){
+      return True;
+    }
+  }
+  return False;
+}
+// Replace one half of a slot, keeping it split only if the second
+// half is in use. Returns what used to be there.
+ShadowValue* swapSlotHalf(UWord* slot, int half, ShadowValue* val){
+  ShadowValue* halves[2] = {slotHalf(*slot, 0), slotHalf(*slot, 1)};
+  ShadowValue* oldVal = halves[half];
+  halves[half] = val;
+  if (halves[1] != NULL){
+    SplitSlot* split;
+    if (SLOT_IS_SPLIT(*slot)){
+      split = SLOT_SPLIT(*slot);
+    } else {
+      split = slabAlloc(sizeof(SplitSlot));
+    }
+    split->halves[0] = halves[0];
+    split->halves[1] = halves[1];
+    *slot = ((UWord)split) | SLOT_SPLIT_TAG;
+  } else {
+    if (SLOT_IS_SPLIT(*slot)){
+      slabFree(SLOT_SPLIT(*slot), sizeof(SplitSlot));
+    }
+    *slot = (UWord)halves[0];
+  }
+  return oldVal;
+}
+void clearMemShadowSlot(SecondaryMap* secondary, Addr64 addr){
+  UWord* slot = &(secondary->slots[(addr & SM_MASK) / sizeof(double)]);
+  if (*slot == 0){
+    return;
+  }
+  ShadowValue* oldVal = slotHalf(*slot, SLOT_HALF(addr));
+  if (oldVal == NULL){
+    return;
+  }
+  if (PRINT_VALUE_MOVES){
+    VG_(printf)("Clearing %llX, which disowns %p (old rc %lu)\n",
+                addr, oldVal, oldVal->ref_count);
+  }
+  swapSlotHalf(slot, SLOT_HALF(addr), NULL);
+  secondary->numLive--;
+  numMemShadows--;
+  unmarkShadowPage(addr);
+  disownShadowValue(oldVal);
 }
 void removeMemShadow(Addr64 addr){
-  int key = addr % LARGE_PRIME;
+  if (!inPrimaryMap(addr)){
+    removeAuxMemShadow(addr);
+    return;
+  }
+  clearMemShadowSlot(primaryMap[addr >> SM_BITS], addr);
+}
+void removeAuxMemShadow(Addr64 addr){
+  int key = addr % AUX_TABLE_SIZE;
   TableValueEntry* prevEntry = NULL;
-  for(TableValueEntry* node = shadowMemTable[key];
+  for(TableValueEntry* node = auxMemTable[key];
       node != NULL; node = node->next){
     if (node->addr == addr){
       if (prevEntry == NULL){
-        shadowMemTable[key] = node->next;
+        auxMemTable[key] = node->next;
       } else {
         prevEntry->next = node->next;
       }
@@ -187,33 +447,451 @@ void removeMemShadow(Addr64 addr){
         VG_(printf)("\n");
       }
       disownShadowValue(node->val);
-      stack_push(tableEntries, (void*)node);
+      slabFree(node, sizeof(TableValueEntry));
+      numAuxMemEntries--;
+      numMemShadows--;
+      if (addr <= MAX_PRIMARY_ADDRESS){
+        primaryMap[addr >> SM_BITS]->
+          pageAux[(addr & SM_MASK) >> SHADOW_PAGE_BITS]--;
+        unmarkShadowPage(addr);
+      }
       break;
     }
     prevEntry = node;
   }
 }
-VG_REGPARM(0) TableValueEntry* newTableValueEntry(void){
-  return VG_(malloc)("tableEntry", sizeof(TableValueEntry));
+// Drop every shadow whose block starts in [start, start + len). We
+// go a secondary map at a time, so 64k chunks with no live shadows
+// are skipped without looking at any of their slots.
+void clearMemShadowRange(Addr64 start, SizeT len){
+  Addr64 end = start + len;
+  Addr64 addr = VG_ROUNDUP(start, sizeof(float));
+  while (addr < end && addr <= MAX_PRIMARY_ADDRESS){
+    Addr64 chunkEnd = ((addr >> SM_BITS) + 1) << SM_BITS;
+    if (chunkEnd > end){
+      chunkEnd = end;
+    }
+    SecondaryMap* secondary = primaryMap[addr >> SM_BITS];
+    if (secondary->numLive == 0){
+      addr = VG_ROUNDUP(chunkEnd, sizeof(float));
+      continue;
+    }
+    for(; addr < chunkEnd; addr += sizeof(float)){
+      clearMemShadowSlot(secondary, addr);
+    }
+  }
+  clearAuxMemShadowRange(start, len);
 }
-inline TableValueEntry* mkTableEntry(void){
-  TableValueEntry* newEntry;
-  if (stack_empty(tableEntries)){
-    newEntry = VG_(malloc)("tableEntry", sizeof(TableValueEntry));
+// Like clearMemShadowRange, but also gives back the secondary maps
+// for any chunks that the range covers completely, since they're
+// empty now.
+void discardMemShadowRange(Addr64 start, SizeT len){
+  if (len == 0){
+    return;
+  }
+  clearMemShadowRange(start, len);
+  Addr64 end = start + len;
+  for(Addr64 chunk = VG_ROUNDUP(start, SM_SIZE);
+      chunk + SM_SIZE <= end && chunk + SM_SIZE - 1 <= MAX_PRIMARY_ADDRESS;
+      chunk += SM_SIZE){
+    if (primaryMap[chunk >> SM_BITS] != &emptySecondaryMap){
+      freeSecondaryMap(primaryMap[chunk >> SM_BITS]);
+    }
+  }
+}
+// Valgrind tells us about these whenever the stack pointer moves. The
+// common case by far is that there's nothing shadowed in the range, so
+// check that before doing anything else.
+void dieMemStack(Addr start, SizeT len){
+  if (len == 0){
+    return;
+  }
+  // Stack moves are usually a page or two, so checking their bits
+  // is only a couple of loads.
+  if (start + len - 1 <= MAX_PRIMARY_ADDRESS &&
+      !anyShadowPageMarked(start, len)){
+    return;
+  }
+  clearMemShadowRange(start, len);
+}
+// New stack memory should already be clean, but frames that get
+// thrown away without the stack pointer going back up, like with
+// longjmp or stack switching, can leave shadows behind.
+void newMemStack(Addr start, SizeT len){
+  dieMemStack(start, len);
+}
+// Drop every auxiliary entry in [start, start + len) by walking the
+// whole table.
+static void clearAuxTableRange(Addr64 start, SizeT len){
+  for(int i = 0; i < AUX_TABLE_SIZE; ++i){
+    TableValueEntry* node = auxMemTable[i];
+    while(node != NULL){
+      TableValueEntry* next = node->next;
+      if (node->addr >= start && node->addr - start < len){
+        removeAuxMemShadow(node->addr);
+      }
+      node = next;
+    }
+  }
+}
+void clearAuxMemShadowRange(Addr64 start, SizeT len){
+  if (numAuxMemEntries == 0 || len == 0){
+    return;
+  }
+  // We can either look up each address that might have an entry, or
+  // walk the whole table, so figure out which is less work. Within
+  // the primary map, only pages with auxiliary entries in them need
+  // looking at, but when there are more pages in the range than
+  // buckets in the table, even checking them costs more than the
+  // walk.
+  if (len / SHADOW_PAGE_SIZE > AUX_TABLE_SIZE){
+    clearAuxTableRange(start, len);
+    return;
+  }
+  Addr64 end = start + len;
+  SizeT numLookups = 0;
+  for(Addr64 addr = start; addr < end;){
+    Addr64 pageEnd = (addr | SHADOW_PAGE_MASK) + 1;
+    if (pageEnd > end){
+      pageEnd = end;
+    }
+    if (addr > MAX_PRIMARY_ADDRESS || pageHasAuxEntries(addr)){
+      numLookups += pageEnd - addr;
+    }
+    addr = pageEnd;
+  }
+  if (numLookups > AUX_TABLE_SIZE){
+    clearAuxTableRange(start, len);
+    return;
+  }
+  for(Addr64 addr = start; addr < end;){
+    Addr64 pageEnd = (addr | SHADOW_PAGE_MASK) + 1;
+    if (pageEnd > end){
+      pageEnd = end;
+    }
+    if (addr > MAX_PRIMARY_ADDRESS || pageHasAuxEntries(addr)){
+      for(; addr < pageEnd; ++addr){
+        if (!inPrimaryMap(addr)){
+          removeAuxMemShadow(addr);
+        }
+      }
+    }
+    addr = pageEnd;
+  }
+}
+// Copy the shadows for [src, src + len) to [dest, dest + len),
+// replacing whatever was shadowing the destination. Works like
+// memmove, so the ranges are allowed to overlap.
+void copyMemShadowRange(Addr64 dest, Addr64 src, SizeT len){
+  if (dest == src || len == 0){
+    return;
+  }
+  if (dest < src + len && src < dest + len){
+    copyOverlappingMemShadowRange(dest, src, len);
+    return;
+  }
+  clearMemShadowRange(dest, len);
+  SizeT offset = 0;
+  while (offset < len){
+    Addr64 addr = src + offset;
+    if (addr > MAX_PRIMARY_ADDRESS){
+      // Up here, everything is in the auxiliary table.
+      if (numAuxMemEntries == 0){
+        break;
+      }
+      ShadowValue* val = getMemShadow(addr);
+      if (val != NULL){
+        addMemShadow(dest + offset, val);
+      }
+      offset += 1;
+      continue;
+    }
+    // Skip pages with nothing shadowed in them, auxiliary entries
+    // included.
+    if (!shadowPageMarked(addr)){
+      offset += ((addr | SHADOW_PAGE_MASK) + 1) - addr;
+      continue;
+    }
+    ShadowValue* val = getMemShadow(addr);
+    if (val != NULL){
+      addMemShadow(dest + offset, val);
+    }
+    // Unaligned addresses can only be shadowed by auxiliary entries,
+    // so if there aren't any, we can go a slot half at a time.
+    if (inPrimaryMap(addr) && numAuxMemEntries == 0){
+      offset += sizeof(float);
+    } else {
+      offset += 1;
+    }
+  }
+  maybeEvictMemShadows();
+}
+// When the ranges overlap, we go in whichever direction reads each
+// source shadow before it gets overwritten, like memmove does.
+void copyOverlappingMemShadowRange(Addr64 dest, Addr64 src, SizeT len){
+  Bool forwards = dest < src;
+  SizeT done = 0;
+  while (done < len){
+    // If the rest of the source page has nothing shadowed in it, we
+    // only need to clear the matching part of the destination. That
+    // part can't cover any source we haven't read yet, since the
+    // destination is behind the source in the direction we're going.
+    Addr64 nextSrc = forwards ? src + done : src + len - done - 1;
+    if (nextSrc <= MAX_PRIMARY_ADDRESS && !shadowPageMarked(nextSrc)){
+      SizeT skip = forwards ?
+        ((nextSrc | SHADOW_PAGE_MASK) + 1) - nextSrc :
+        (nextSrc & SHADOW_PAGE_MASK) + 1;
+      if (skip > len - done){
+        skip = len - done;
+      }
+      clearMemShadowRange(forwards ? dest + done : dest + len - done - skip,
+                          skip);
+      done += skip;
+      continue;
+    }
+    SizeT step = 1;
+    if (numAuxMemEntries == 0){
+      Addr64 nextSrc = forwards ? src + done : src + len - done - sizeof(float);
+      Addr64 nextDest = forwards ? dest + done : dest + len - done - sizeof(float);
+      if (len - done >= sizeof(float) &&
+          inPrimaryMap(nextSrc) && inPrimaryMap(nextDest)){
+        step = sizeof(float);
+      }
+    }
+    SizeT offset = forwards ? done : len - done - step;
+    ShadowValue* val = getMemShadow(src + offset);
+    removeMemShadow(dest + offset);
+    if (val != NULL){
+      addMemShadow(dest + offset, val);
+    }
+    done += step;
+  }
+  maybeEvictMemShadows();
+}
+// A rough count of how much memory the memory shadows are holding
+// on to. Values shared between several locations get counted for each
+// of them, so this errs on the high side.
+SizeT estimateMemShadowBytes(void){
+  return numMemShadows * (sizeof(ShadowValue) + shadowValueRecordSize()) +
+    numAuxMemEntries * sizeof(TableValueEntry) +
+    numSecondaryMaps * sizeof(SecondaryMap);
+}
+// Called after anything that can add a lot of memory shadows. When
+// we're over the limit, we evict down to seven eighths of it, so that
+// we aren't doing this again on the very next store.
+void maybeEvictMemShadows(void){
+  if (shadow_memory_limit == 0){
+    return;
+  }
+  SizeT limitBytes = ((SizeT)shadow_memory_limit) << 20;
+  if (estimateMemShadowBytes() > limitBytes){
+    evictMemShadows(limitBytes - limitBytes / 8);
+  }
+}
+static Int cmpLastTouched(const void* a, const void* b){
+  ULong aTouched = (*(SecondaryMap* const*)a)->lastTouched;
+  ULong bTouched = (*(SecondaryMap* const*)b)->lastTouched;
+  if (aTouched < bTouched) return -1;
+  if (aTouched > bTouched) return 1;
+  return 0;
+}
+static Int cmpEntryLastTouched(const void* a, const void* b){
+  ULong aTouched = (*(TableValueEntry* const*)a)->lastTouched;
+  ULong bTouched = (*(TableValueEntry* const*)b)->lastTouched;
+  if (aTouched < bTouched) return -1;
+  if (aTouched > bTouched) return 1;
+  return 0;
+}
+// Throw out shadows, least recently touched first, until we're under
+// targetBytes. Within the primary map we go a whole 64k chunk at a
+// time, auxiliary entries included. Auxiliary entries past the
+// primary map go one by one, interleaved with the chunks by their own
+// stamps. The locations go back to being unshadowed, so the next time
+// they're used they'll get fresh shadows from their client values.
+void evictMemShadows(SizeT targetBytes){
+  UWord shadowsBefore = numMemShadows;
+  SecondaryMap** bySecondary =
+    VG_(malloc)("evictionOrder",
+                (numSecondaryMaps + 1) * sizeof(SecondaryMap*));
+  UWord numSecondaries = 0;
+  for(SecondaryMap* secondary = allocatedSecondaries;
+      secondary != NULL; secondary = secondary->next){
+    bySecondary[numSecondaries++] = secondary;
+  }
+  tl_assert(numSecondaries == numSecondaryMaps);
+  VG_(ssort)(bySecondary, numSecondaries, sizeof(SecondaryMap*),
+             cmpLastTouched);
+  TableValueEntry** byEntry =
+    VG_(malloc)("evictionOrder",
+                (numAuxMemEntries + 1) * sizeof(TableValueEntry*));
+  UWord numEntries = 0;
+  for(int i = 0; i < AUX_TABLE_SIZE; ++i){
+    for(TableValueEntry* node = auxMemTable[i];
+        node != NULL; node = node->next){
+      if (node->addr > MAX_PRIMARY_ADDRESS){
+        byEntry[numEntries++] = node;
+      }
+    }
+  }
+  VG_(ssort)(byEntry, numEntries, sizeof(TableValueEntry*),
+             cmpEntryLastTouched);
+  // Clearing a chunk only removes entries inside the primary map, so
+  // the entries we collected stay valid until we remove them.
+  UWord i = 0, j = 0;
+  while((i < numSecondaries || j < numEntries) &&
+        estimateMemShadowBytes() > targetBytes){
+    if (j == numEntries ||
+        (i < numSecondaries &&
+         bySecondary[i]->lastTouched <= byEntry[j]->lastTouched)){
+      clearMemShadowRange(bySecondary[i]->base, SM_SIZE);
+      freeSecondaryMap(bySecondary[i]);
+      i++;
+    } else {
+      removeAuxMemShadow(byEntry[j]->addr);
+      j++;
+    }
+  }
+  VG_(free)(bySecondary);
+  VG_(free)(byEntry);
+  numEvictedMemShadows += shadowsBefore - numMemShadows;
+  if (print_allocs){
+    VG_(printf)("Evicted %lu memory shadows to stay under %dMB\n",
+                shadowsBefore - numMemShadows, shadow_memory_limit);
+  }
+}
+#define MAX_CHAIN_HIST 8
+void printShadowMemStats(void){
+  UWord numSplitSlots = 0;
+  for(SecondaryMap* secondary = allocatedSecondaries;
+      secondary != NULL; secondary = secondary->next){
+    for(int i = 0; i < SM_SLOTS; ++i){
+      if (SLOT_IS_SPLIT(secondary->slots[i])){
+        numSplitSlots++;
+      }
+    }
+  }
+  // The last bucket counts every chain at least that long.
+  UWord chainHist[MAX_CHAIN_HIST + 1] = {0};
+  UWord longestChain = 0;
+  for(int i = 0; i < AUX_TABLE_SIZE; ++i){
+    UWord length = 0;
+    for(TableValueEntry* node = auxMemTable[i];
+        node != NULL; node = node->next){
+      length++;
+    }
+    if (length > longestChain){
+      longestChain = length;
+    }
+    chainHist[length < MAX_CHAIN_HIST ? length : MAX_CHAIN_HIST]++;
+  }
+
+  VG_(printf)("Shadow memory:\n");
+  VG_(printf)("  %lu live memory shadows, about %lu bytes\n",
+              numMemShadows, estimateMemShadowBytes());
+  VG_(printf)("  %lu secondary maps, %lu split slots\n",
+              numSecondaryMaps, numSplitSlots);
+  VG_(printf)("  %lu auxiliary table entries, longest chain %lu\n",
+              numAuxMemEntries, longestChain);
+  VG_(printf)("  auxiliary chain lengths:");
+  for(int i = 0; i <= MAX_CHAIN_HIST; ++i){
+    VG_(printf)(" %d%s:%lu", i, i == MAX_CHAIN_HIST ? "+" : "",
+                chainHist[i]);
+  }
+  VG_(printf)("\n");
+  VG_(printf)("  %llu shadows evicted\n", numEvictedMemShadows);
+  if (print_shadow_stats){
+    VG_(printf)("  %llu inline memory checks, %llu went to C (%llu%%)\n",
+                numInlineMemChecks, numInlineMemChecksToC,
+                numInlineMemChecks == 0 ? 0 :
+                (numInlineMemChecksToC * 100) / numInlineMemChecks);
+  }
+  VG_(printf)("  %llu dynamic loads, %llu dynamic stores\n",
+              numDynamicLoads, numSetMemShadowTemps);
+  VG_(printf)("  %llu lazy leaves made, %llu of them materialized\n",
+              numLazyLeaves, numMaterializedLeaves);
+  VG_(printf)("  %lu interned leaf values, %llu intern hits, "
+              "%llu misses (%llu with the table full)\n",
+              numInternedValues, numInternHits, numInternMisses,
+              numInternFullMisses);
+  VG_(printf)("  %llu deferred frees applied, %llu values picked back "
+              "up before their free\n",
+              numDeferredFreesApplied, numDeferredFreesRescued);
+  if (shadow_gc == Gc_MarkSweep){
+    VG_(printf)("  %llu collections swept up %llu values, "
+                "%lu values still tracked\n",
+                numCollections, numCollectedValues, numGCValues);
+  }
+  printSlabStats();
+  printSlabClassStats("shadow value headers", &shadowValueHeaders);
+  VG_(printf)("  temp freelists:");
+  for(int i = 0; i < MAX_TEMP_BLOCKS; ++i){
+    VG_(printf)(" %lu", stack_size(freedTemps[i]));
+  }
+  VG_(printf)("\n");
+}
+// Only for secondary maps with nothing left in them.
+void freeSecondaryMap(SecondaryMap* secondary){
+  tl_assert(secondary->numLive == 0);
+  if (secondary->prev == NULL){
+    allocatedSecondaries = secondary->next;
   } else {
-    newEntry = (void*)stack_pop(tableEntries);
+    secondary->prev->next = secondary->next;
   }
-  return newEntry;
+  if (secondary->next != NULL){
+    secondary->next->prev = secondary->prev;
+  }
+  numSecondaryMaps--;
+  primaryMap[secondary->base >> SM_BITS] = &emptySecondaryMap;
+  VG_(free)(secondary);
+}
+VG_REGPARM(0) TableValueEntry* newTableValueEntry(void){
+  return slabAlloc(sizeof(TableValueEntry));
+}
+inline TableValueEntry* mkTableEntry(void){
+  return slabAlloc(sizeof(TableValueEntry));
 }
 void addMemShadow(Addr64 addr, ShadowValue* val){
+  if (!inPrimaryMap(addr)){
+    addAuxMemShadow(addr, val);
+    return;
+  }
+  SecondaryMap* secondary = getSecondaryMapForWriting(addr);
+  UWord* slot = &(secondary->slots[(addr & SM_MASK) / sizeof(double)]);
+  ShadowValue* oldVal = swapSlotHalf(slot, SLOT_HALF(addr), val);
+  tl_assert2(oldVal == NULL,
+             "Setting %llX to %p, but it still holds %p!\n",
+             addr, val, oldVal);
+  ownShadowValue(val);
+  secondary->numLive++;
+  secondary->lastTouched = ++memShadowClock;
+  numMemShadows++;
+  markShadowPage(addr);
+  if (PRINT_VALUE_MOVES){
+    VG_(printf)("Setting %llX to %p", addr, val);
+    if (val != NULL){
+      VG_(printf)(" (new rc %lu)", val->ref_count);
+    }
+    VG_(printf)("\n");
+  }
+}
+void addAuxMemShadow(Addr64 addr, ShadowValue* val){
   TableValueEntry* newEntry = mkTableEntry();
   newEntry->addr = addr;
   newEntry->val = val;
+  newEntry->lastTouched = ++memShadowClock;
   ownShadowValue(val);
 
-  int key = addr % LARGE_PRIME;
-  newEntry->next = shadowMemTable[key];
-  shadowMemTable[key] = newEntry;
+  int key = addr % AUX_TABLE_SIZE;
+  newEntry->next = auxMemTable[key];
+  auxMemTable[key] = newEntry;
+  numAuxMemEntries++;
+  numMemShadows++;
+  if (addr <= MAX_PRIMARY_ADDRESS){
+    markShadowPage(addr);
+    primaryMap[addr >> SM_BITS]->
+      pageAux[(addr & SM_MASK) >> SHADOW_PAGE_BITS]++;
+    primaryMap[addr >> SM_BITS]->lastTouched = ++memShadowClock;
+  }
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Setting %llX to %p", addr, val);
     if (val != NULL){
@@ -244,41 +922,49 @@ void freeShadowValue(ShadowValue* val){
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Disowned last reference to %p! Freeing...\n", val);
   }
-  if (val->influences != NULL){
-    freeInfluenceList(val->influences);
-    val->influences = NULL;
+  if (val->cold->influences != NULL){
+    freeInfluenceList(val->cold->influences);
+    val->cold->influences = NULL;
   }
-  if (!no_exprs){
+  if (!no_exprs && val->cold->expr != NULL){
     if (print_expr_refs){
       VG_(printf)("Disowning expression %p as part of freeing val %p\n",
-                  val->expr, val);
+                  val->cold->expr, val);
     }
-    disownConcExpr(val->expr);
+    disownConcExpr(val->cold->expr);
   }
-  double value = getDouble(val->real);
-  if (value == 0.0) value = 0.0;
-  if (isNaN(val->real)) value = NAN;
-  TableValueEntry* entry =
-    VG_(HT_remove)(val->type == Vt_Single ? valueCacheSingle : valueCacheDouble,
-                   *(UWord*)&value);
-  if (entry != NULL){
-    stack_push(tableEntries, (void*)entry);
+  if (val->interned){
+    uninternShadowValue(val);
   }
-  stack_push_fast(freedVals, (void*)val);
+  // Values that started out lazy only have the cold fields in their
+  // side record, with their real (if they ever got one) allocated
+  // separately.
+  if (!no_reals && (val->lazy || val->real != (Real)(val->cold + 1))){
+    if (!val->lazy){
+      slabFree(val->real, realSize());
+    }
+    slabFree_fast(val->cold, sizeof(ShadowValueCold));
+  } else {
+    slabFree_fast(val->cold, shadowValueRecordSize());
+  }
+  slabClassFree_fast(&shadowValueHeaders, val);
 }
 
 ShadowValue* copyShadowValue(ShadowValue* val){
+  if (val->lazy){
+    return newLazyLeaf(val->type, val->cold->leafValue);
+  }
   ShadowValue* copy = mkShadowValueBare(val->type);
   if (!no_reals){
     copyReal(val->real, copy->real);
   }
-  copy->expr = val->expr;
+  copy->cold->expr = val->cold->expr;
   if (!no_exprs){
-    recursivelyOwnConcExpr(copy->expr,
+    recursivelyOwnConcExpr(copy->cold->expr,
                            max_expr_block_depth * 2);
   }
   if (!no_influences){
-    copy->influences = cloneInfluences(val->influences);
+    copy->cold->influences = cloneInfluences(val->cold->influences);
   }
   return copy;
 }
@@ -286,62 +972,190 @@ inline
 ShadowValue* mkShadowValueBare(ValueType type){
   tl_assert2(type == Vt_Single || type == Vt_Double,
              "Invalid type! %s\n", typeName(type));
-  ShadowValue* result;
-  if (stack_empty_fast(freedVals)){
-    result = newShadowValue(type);
-    if (PRINT_VALUE_MOVES || print_allocs){
-      VG_(printf)("Alloced new shadow value %p\n", result);
-    }
-  } else {
-    result = (void*)stack_pop_fast(freedVals);
-    tl_assert2(result->ref_count == 0,
-               "Shadow value %p just popped off the stack has a ref count of %d!\n",
-               result, result->ref_count);
-    result->type = type;
+  ShadowValue* result = newShadowValue(type);
+  if (shadow_gc == Gc_MarkSweep){
+    trackShadowValue(result);
+  }
+  if (PRINT_VALUE_MOVES || print_allocs){
+    VG_(printf)("Alloced shadow value %p\n", result);
   }
-  result->ref_count = 1;
   return result;
 }
+// Makes the result values for all the lanes of a SIMD op at once.
+void mkShadowValuesBare(ValueType type, int count, ShadowValue** out){
+  tl_assert2(type == Vt_Single || type == Vt_Double,
+             "Invalid type! %s\n", typeName(type));
+  for(int i = 0; i < count; ++i){
+    out[i] = newShadowValue(type);
+  }
+  if (shadow_gc == Gc_MarkSweep){
+    for(int i = 0; i < count; ++i){
+      trackShadowValue(out[i]);
+    }
+  }
+  if (PRINT_VALUE_MOVES || print_allocs){
+    for(int i = 0; i < count; ++i){
+      VG_(printf)("Alloced shadow value %p\n", out[i]);
+    }
+  }
+}
 
 VG_REGPARM(2) ShadowValue* mkShadowValue_wrapper(ValueType type, UWord value){
   return mkShadowValue(type, *(double*)(void*)&value);
 }
-VgHashTable* valueCacheSingle;
-VgHashTable* valueCacheDouble;
-inline
-ShadowValue* mkShadowValue(ValueType type, double value){
+InternEntry* internTable;
+UWord numInternedValues = 0;
+ULong numInternHits = 0;
+ULong numInternMisses = 0;
+ULong numInternFullMisses = 0;
+
+static inline UWord internKey(double value){
+  // All zeroes and all NaNs look the same to us.
   if (value == 0.0) value = 0.0;
   if (value != value) value = NAN;
-  UWord key = *(UWord*)&value;
-  TableValueEntry* existingEntry =
-    VG_(HT_lookup)(type == Vt_Single ? valueCacheSingle : valueCacheDouble, key);
-  ShadowValue* result = NULL;
-  if (existingEntry == NULL || no_reals){
-    result = mkShadowValueBare(type);
-    if (!no_reals){
-      if (PRINT_VALUE_MOVES){
-        VG_(printf)("Setting shadow value %p to initial value of ", result);
-        ppFloat(value);
-        VG_(printf)("\n");
-      }
-      setReal(result->real, value);
-
-      ValueCacheEntry* newEntry = (void*)mkTableEntry();
-      newEntry->val = result;
-      newEntry->key = key;
-      VG_(HT_add_node)(type == Vt_Single ? valueCacheSingle : valueCacheDouble,
-                       newEntry);
+  return *(UWord*)&value;
+}
+static inline UWord internHash(UWord key){
+  return (UWord)(((ULong)key * 0x9E3779B97F4A7C15ULL) >>
+                 (64 - INTERN_TABLE_BITS));
+}
+// Take a value out of the intern table, shifting back anything after
+// it in its probe run that would otherwise become unreachable.
+void uninternShadowValue(ShadowValue* val){
+  UWord mask = INTERN_TABLE_SIZE - 1;
+  UWord idx = internHash(internKey(getDouble(val->real)));
+  while(internTable[idx].val != val){
+    tl_assert2(internTable[idx].val != NULL,
+               "Interned value %p isn't in the intern table!\n", val);
+    idx = (idx + 1) & mask;
+  }
+  UWord next = (idx + 1) & mask;
+  while(internTable[next].val != NULL){
+    UWord home = internHash(internTable[next].key);
+    if (((next - home) & mask) >= ((next - idx) & mask)){
+      internTable[idx] = internTable[next];
+      idx = next;
     }
+    next = (next + 1) & mask;
+  }
+  internTable[idx].val = NULL;
+  numInternedValues--;
+  val->interned = False;
+}
+// Find the intern table entry for this key and type, or the empty
+// entry where it would go.
+static inline InternEntry* findInternEntry(UWord key, ValueType type){
+  UWord mask = INTERN_TABLE_SIZE - 1;
+  UWord idx = internHash(key);
+  while(internTable[idx].val != NULL){
+    if (internTable[idx].key == key && internTable[idx].val->type == type){
+      break;
+    }
+    idx = (idx + 1) & mask;
+  }
+  return &(internTable[idx]);
+}
+inline
+ShadowValue* mkShadowValue(ValueType type, double value){
+  ShadowValue* result;
+  if (no_reals){
+    result = mkShadowValueBare(type);
     if (!no_exprs){
-      result->expr = mkLeafConcExpr(value);
+      result->cold->expr = mkLeafConcExpr(value);
     }
-  } else {
-    result = existingEntry->val;
+    return result;
+  }
+  UWord key = internKey(value);
+  InternEntry* entry = findInternEntry(key, type);
+  if (entry->val != NULL){
+    numInternHits++;
+    result = entry->val;
     ownShadowValue(result);
+    return result;
+  }
+  numInternMisses++;
+
+  result = mkShadowValueBare(type);
+  if (PRINT_VALUE_MOVES){
+    VG_(printf)("Setting shadow value %p to initial value of ", result);
+    ppFloat(value);
+    VG_(printf)("\n");
+  }
+  setReal(result->real, value);
+  if (!no_exprs){
+    result->cold->expr = mkLeafConcExpr(value);
+  }
+  if (numInternedValues < MAX_INTERNED_VALUES){
+    entry->key = key;
+    entry->val = result;
+    result->interned = True;
+    numInternedValues++;
+  } else {
+    numInternFullMisses++;
   }
   return result;
 }
 
+ULong numLazyLeaves = 0;
+ULong numMaterializedLeaves = 0;
+
+static ShadowValue* newLazyLeaf(ValueType type, double value){
+  ShadowValue* result = slabClassAlloc_fast(&shadowValueHeaders);
+  result->type = type;
+  result->ref_count = 1;
+  result->real = NULL;
+  result->cold = slabAlloc_fast(sizeof(ShadowValueCold));
+  result->cold->expr = NULL;
+  result->cold->influences = NULL;
+  result->interned = False;
+  result->lazy = True;
+  result->freePending = False;
+  result->marked = False;
+  result->cold->leafValue = value;
+  numLazyLeaves++;
+  if (shadow_gc == Gc_MarkSweep){
+    trackShadowValue(result);
+  }
+  if (PRINT_VALUE_MOVES || print_allocs){
+    VG_(printf)("Alloced lazy leaf %p\n", result);
+  }
+  return result;
+}
+// Most of the values we make from client data only get moved around,
+// and never reach an op or a mark. So these start out as lazy
+// leaves, which only keep the client value, and get their real and
+// expression the first time someone asks for them. If there's
+// already an interned value for this client value, we just share
+// that.
+ShadowValue* mkLazyShadowValue(ValueType type, double value){
+  if (no_reals){
+    return mkShadowValue(type, value);
+  }
+  InternEntry* entry = findInternEntry(internKey(value), type);
+  if (entry->val != NULL){
+    numInternHits++;
+    ownShadowValue(entry->val);
+    return entry->val;
+  }
+  return newLazyLeaf(type, value);
+}
+void materializeLazyLeaf(ShadowValue* val){
+  tl_assert(val->lazy);
+  val->real = slabAlloc(realSize());
+  initRealAt(val->real);
+  setReal(val->real, val->cold->leafValue);
+  if (!no_exprs){
+    val->cold->expr = mkLeafConcExpr(val->cold->leafValue);
+  }
+  val->lazy = False;
+  numMaterializedLeaves++;
+}
+void materializeShadowTemp(ShadowTemp* temp){
+  for(int i = 0; i < INT(temp->num_blocks); ++i){
+    materializeShadowValue(temp->values[i]);
+  }
+}
+
 VG_REGPARM(1) ShadowTemp* copyShadowTemp(ShadowTemp* temp){
   ShadowTemp* result = mkShadowTemp(temp->num_blocks);
   tl_assert(INT(result->num_blocks) == INT(temp->num_blocks));
@@ -399,17 +1213,116 @@ VG_REGPARM(1) void disownShadowTempDynamic(IRTemp idx){
   }
 }
 void disownShadowValue(ShadowValue* val){
-  if (val == NULL) return;
+  if (val == NULL || shadow_gc == Gc_MarkSweep) return;
   tl_assert2(val->ref_count > 0,
              "Trying to disown %p, but it's ref count is already %lu!\n",
              val, val->ref_count);
   val->ref_count--;
   if (val->ref_count == 0){
-    freeShadowValue(val);
+    deferFreeShadowValue(val);
+  }
+}
+// Values pass through zero references all the time inside a block,
+// as they get moved out of one temp and into another, or dropped
+// from a register just before the same value gets stored back. So
+// instead of freeing a value the moment its count hits zero, we put
+// it in a buffer, and only free the ones which are still at zero
+// when the block finishes (or the buffer fills up).
+void deferFreeShadowValue(ShadowValue* val){
+  if (val->freePending) return;
+  if (numDeferredFrees == MAX_DEFERRED_FREES){
+    flushDeferredFrees();
+  }
+  val->freePending = True;
+  deferredFrees[numDeferredFrees++] = val;
+}
+void flushDeferredFrees(void){
+  for(int i = 0; i < numDeferredFrees; ++i){
+    ShadowValue* val = deferredFrees[i];
+    val->freePending = False;
+    if (val->ref_count == 0){
+      freeShadowValue(val);
+      numDeferredFreesApplied++;
+    } else {
+      numDeferredFreesRescued++;
+    }
+  }
+  numDeferredFrees = 0;
+}
+// With --shadow-gc=mark-sweep, every value we make goes in
+// gcValues, and once enough have been made since the last
+// collection, we set gcPending so that the next block exit will
+// collect.
+void trackShadowValue(ShadowValue* val){
+  if (numGCValues == gcValuesCapacity){
+    gcValuesCapacity = gcValuesCapacity == 0 ? MIN_GC_INTERVAL :
+      gcValuesCapacity * 2;
+    gcValues = VG_(realloc)("gc values", gcValues,
+                            gcValuesCapacity * sizeof(ShadowValue*));
+  }
+  gcValues[numGCValues++] = val;
+  if (gcAllocsUntilCollect > 0){
+    gcAllocsUntilCollect--;
+    if (gcAllocsUntilCollect == 0){
+      gcPending = 1;
+    }
   }
 }
+static void markShadowValue(ShadowValue* val){
+  if (val != NULL){
+    val->marked = True;
+  }
+}
+// This only gets called at the end of a block, once its temps have
+// been cleaned up, so the only roots are the thread states and
+// shadow memory. The intern table doesn't keep anything alive;
+// swept values come out of it as they're freed.
+void collectShadowValues(void){
+  for(int tid = 0; tid < VG_N_THREADS; ++tid){
+    ShadowValue** threadState = shadowThreadState[tid];
+    if (threadState == NULL) continue;
+    for(int i = 0; i < MAX_REGISTERS; ++i){
+      markShadowValue(threadState[i]);
+    }
+  }
+  for(SecondaryMap* secondary = allocatedSecondaries;
+      secondary != NULL; secondary = secondary->next){
+    if (secondary->numLive == 0) continue;
+    for(int i = 0; i < SM_SLOTS; ++i){
+      UWord slot = secondary->slots[i];
+      if (slot == 0) continue;
+      markShadowValue(slotHalf(slot, 0));
+      markShadowValue(slotHalf(slot, 1));
+    }
+  }
+  for(int i = 0; i < AUX_TABLE_SIZE; ++i){
+    for(TableValueEntry* node = auxMemTable[i];
+        node != NULL; node = node->next){
+      markShadowValue(node->val);
+    }
+  }
+
+  UWord numLive = 0;
+  for(UWord i = 0; i < numGCValues; ++i){
+    ShadowValue* val = gcValues[i];
+    if (val->marked){
+      val->marked = False;
+      gcValues[numLive++] = val;
+    } else {
+      freeShadowValue(val);
+      numCollectedValues++;
+    }
+  }
+  numGCValues = numLive;
+  // Wait until the heap has about doubled before collecting again,
+  // so collections stay proportional to allocation.
+  gcAllocsUntilCollect =
+    numLive > MIN_GC_INTERVAL ? numLive : MIN_GC_INTERVAL;
+  gcPending = 0;
+  numCollections++;
+}
 void ownShadowValue(ShadowValue* val){
-  if (val == NULL) return;
+  if (val == NULL || shadow_gc == Gc_MarkSweep) return;
   (val->ref_count)++;
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Owning shadow value %p (new ref count %lu)\n", val, val->ref_count);
@@ -418,7 +1331,7 @@ void ownShadowValue(ShadowValue* val){
 
 VG_REGPARM(1) ShadowTemp* mkShadowTempOneDouble(UWord value){
   ShadowTemp* result = mkShadowTemp(FB(2));
-  result->values[0] = mkShadowValue(Vt_Double, *(double*)&value);
+  result->values[0] = mkLazyShadowValue(Vt_Double, *(double*)&value);
   result->values[1] = NULL;
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Making value %p as one double temp %p\n",
@@ -429,10 +1342,10 @@ VG_REGPARM(1) ShadowTemp* mkShadowTempOneDouble(UWord value){
 VG_REGPARM(1) ShadowTemp* mkShadowTempTwoDoubles(UWord* values){
   ShadowTemp* result = mkShadowTemp(FB(4));
   result->values[0] =
-    mkShadowValue(Vt_Double, ((double*)values)[0]);
+    mkLazyShadowValue(Vt_Double, ((double*)values)[0]);
   result->values[1] = NULL;
   result->values[2] =
-    mkShadowValue(Vt_Double, ((double*)values)[1]);
+    mkLazyShadowValue(Vt_Double, ((double*)values)[1]);
   result->values[3] = NULL;
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Making values %p and %p as part of two double temp %p\n",
@@ -442,7 +1355,7 @@ VG_REGPARM(1) ShadowTemp* mkShadowTempTwoDoubles(UWord* values){
 }
 VG_REGPARM(1) ShadowTemp* mkShadowTempOneSingle(UWord value){
   ShadowTemp* result = mkShadowTemp(FB(1));
-  result->values[0] = mkShadowValue(Vt_Single, *(double*)&value);
+  result->values[0] = mkLazyShadowValue(Vt_Single, *(double*)&value);
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Making value %p as part of one single temp %p\n",
                 result->values[0], result);
@@ -453,8 +1366,8 @@ VG_REGPARM(1) ShadowTemp* mkShadowTempTwoSingles(UWord values){
   ShadowTemp* result = mkShadowTemp(FB(2));
   float floatValues[2];
   VG_(memcpy)(floatValues, &values, sizeof(floatValues));
-  result->values[0] = mkShadowValue(Vt_Single, floatValues[0]);
-  result->values[1] = mkShadowValue(Vt_Single, floatValues[1]);
+  result->values[0] = mkLazyShadowValue(Vt_Single, floatValues[0]);
+  result->values[1] = mkLazyShadowValue(Vt_Single, floatValues[1]);
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Making values %p and %p "
                 "as part of two singles temp %p\n",
@@ -466,13 +1379,13 @@ inline
 VG_REGPARM(1) ShadowTemp* mkShadowTempFourSingles(float* values){
   ShadowTemp* result = mkShadowTemp(FB(4));
   result->values[0] =
-    mkShadowValue(Vt_Single, values[0]);
+    mkLazyShadowValue(Vt_Single, values[0]);
   result->values[1] =
-    mkShadowValue(Vt_Single, values[1]);
+    mkLazyShadowValue(Vt_Single, values[1]);
   result->values[2] =
-    mkShadowValue(Vt_Single, values[2]);
+    mkLazyShadowValue(Vt_Single, values[2]);
   result->values[3] =
-    mkShadowValue(Vt_Single, values[3]);
+    mkLazyShadowValue(Vt_Single, values[3]);
   if (PRINT_VALUE_MOVES){
     VG_(printf)("Making values %p, %p, %p, and %p "
                 "as part of four single temp %p\n",
@@ -37,12 +37,15 @@
 // * Values that persist between blocks (I think this is how it
 //   works), are held in a per thread data structure by VEX, so we set
 //   up another array for every thread to hold those, also up to a
-//   limit set in the .h file.
+//   limit set in the .h file. These get allocated when a thread is
+//   created, and whenever Valgrind switches threads we point
+//   curThreadState at the array for the new one.
 //
 // * Finally, values might be written to memory, and then read out
-//   later at some arbitrary point. For these, we'll maintain a hash
-//   table that maps addresses to shadow values, so we don't have to
-//   maintain a vast array of shadow values for all of memory.
+//   later at some arbitrary point. For these, we'll maintain a
+//   two-level map from addresses to shadow values, like memcheck's
+//   primary and secondary maps, so that we only have to allocate
+//   shadow space for the parts of memory that actually get touched.
 
 #ifndef _VALUE_SHADOWSTATE_H
 #define _VALUE_SHADOWSTATE_H
@@ -54,22 +57,106 @@
 #include "pub_tool_libcprint.h"
 
 #include "../../helper/stack.h"
+#include "../../helper/slab.h"
 
-#define MAX_THREADS 16
+// The primary map is indexed by the high bits of an address, and
+// points to secondary maps which have a slot for every eight-byte
+// unit in a 64k chunk of memory. Secondary maps are allocated the
+// first time something is written to them; until then, the primary
+// map points at a shared secondary map which is always empty, so a
+// lookup is always exactly two loads.
+#define SM_BITS 16
+#define SM_SIZE (1 << SM_BITS)
+#define SM_MASK (SM_SIZE - 1)
+#define SM_SLOTS (SM_SIZE / sizeof(double))
+#define N_PRIMARY_BITS 21
+#define N_PRIMARY_MAP (((UWord)1) << N_PRIMARY_BITS)
+#define MAX_PRIMARY_ADDRESS ((((Addr)SM_SIZE) * N_PRIMARY_MAP) - 1)
 
-#define LARGE_PRIME 1572869
+// Each slot covers two four-byte blocks. Usually only the first one
+// is shadowed (an aligned double, or a single that's on its own), so
+// the slot just holds that shadow value. When the second block is
+// shadowed too, the slot instead holds a tagged pointer to a
+// SplitSlot, which has room for both.
+#define SLOT_SPLIT_TAG ((UWord)1)
+#define SLOT_IS_SPLIT(slot) (((slot) & SLOT_SPLIT_TAG) != 0)
+#define SLOT_SPLIT(slot) ((SplitSlot*)((slot) & ~SLOT_SPLIT_TAG))
+#define SLOT_HALF(addr) (((addr) / sizeof(float)) & 1)
+
+// On top of that, we keep one bit for every page covered by the
+// primary map, which is set whenever anything in that page (including
+// auxiliary table entries) is shadowed. Most memory traffic is to
+// pages that have never held a shadowed float, so the instrumentation
+// can check this bit first and skip everything else.
+#define SHADOW_PAGE_BITS 12
+#define SHADOW_PAGE_SIZE (1 << SHADOW_PAGE_BITS)
+#define SHADOW_PAGE_MASK (SHADOW_PAGE_SIZE - 1)
+#define SM_PAGES (SM_SIZE >> SHADOW_PAGE_BITS)
+#define N_SHADOW_PAGES (N_PRIMARY_MAP * SM_PAGES)
+#define SHADOW_PAGE_BITMAP_WORDS (N_SHADOW_PAGES / (8 * sizeof(UWord)))
+
+// Addresses which aren't four-byte aligned, or which are past the
+// end of the primary map, go in a (hopefully small) chained hash
+// table instead.
+#define AUX_TABLE_SIZE 65537
+#define AUX_ADDR_MASK (~((Addr)MAX_PRIMARY_ADDRESS) | (sizeof(float) - 1))
 
 typedef struct _tableValueEntry {
   struct _tableValueEntry* next;
   UWord addr;
   ShadowValue* val;
+  // Entries past the primary map have no secondary map to stamp, so
+  // they carry their own stamp for --shadow-memory-limit.
+  ULong lastTouched;
 } TableValueEntry;
 
-typedef struct _valueCacheEntry {
-  struct _valueCacheEntry* next;
+typedef struct _splitSlot {
+  struct _splitSlot* next;
+  ShadowValue* halves[2];
+} SplitSlot;
+
+typedef struct _secondaryMap {
+  UWord slots[SM_SLOTS];
+  // Every allocated secondary map is on a list, so that when we go
+  // over --shadow-memory-limit we can find the ones that were touched
+  // least recently and throw them out.
+  struct _secondaryMap* prev;
+  struct _secondaryMap* next;
+  Addr64 base;
+  ULong lastTouched;
+  // How many blocks in this chunk are shadowed, so that clearing a
+  // range can skip chunks which used to have shadows but don't
+  // anymore.
+  UInt numLive;
+  // How many shadows (slots or auxiliary entries) are in each page,
+  // so we know when to clear its bit in shadowPageBitmap.
+  UShort pageLive[SM_PAGES];
+  // How many of those are auxiliary entries, so that clearing a
+  // range only has to look up addresses in pages that have some.
+  UShort pageAux[SM_PAGES];
+} SecondaryMap;
+
+// Leaf values made from the same client double share a shadow
+// value, found through an open-addressing table keyed on the
+// double's bits. The table doesn't own its values; they come out of
+// it when they're freed. Once it's half full we stop adding to it,
+// so that probes stay short.
+#define INTERN_TABLE_BITS 16
+#define INTERN_TABLE_SIZE (1 << INTERN_TABLE_BITS)
+#define MAX_INTERNED_VALUES (INTERN_TABLE_SIZE / 2)
+
+typedef struct _internEntry {
   UWord key;
   ShadowValue* val;
-} ValueCacheEntry;
+} InternEntry;
+
+// How many values can be waiting to be freed at once. Normally the
+// buffer gets flushed at the end of every block.
+#define MAX_DEFERRED_FREES 1024
+
+// With --shadow-gc=mark-sweep, the fewest values we'll make between
+// two collections.
+#define MIN_GC_INTERVAL (1 << 16)
 
 typedef union {
   float argValuesF[4][8];
@@ -86,14 +173,31 @@ extern ArgUnion computedArgs;
 extern ResultUnion computedResult;
 
 extern ShadowTemp* shadowTemps[MAX_TEMPS];
-extern ShadowValue* shadowThreadState[MAX_THREADS][MAX_REGISTERS];
-extern TableValueEntry* shadowMemTable[LARGE_PRIME];
+// Indexed by thread id. There's room for VG_N_THREADS of them, but
+// the arrays themselves only exist for live threads.
+extern ShadowValue*** shadowThreadState;
+extern ShadowValue** curThreadState;
+extern SecondaryMap* primaryMap[N_PRIMARY_MAP];
+extern SecondaryMap emptySecondaryMap;
+extern TableValueEntry* auxMemTable[AUX_TABLE_SIZE];
+extern UWord numAuxMemEntries;
+extern UWord shadowPageBitmap[SHADOW_PAGE_BITMAP_WORDS];
+extern UWord numMemShadows;
+extern ULong numEvictedMemShadows;
+// Only counted with --print-shadow-stats.
+extern ULong numInlineMemChecks;
+extern ULong numInlineMemChecksToC;
+extern ULong numDynamicLoads;
+extern ULong numSetMemShadowTemps;
 
 extern Stack* freedTemps[MAX_TEMP_BLOCKS];
-extern Stack* freedVals;
-extern Stack* tableEntries;
-extern VgHashTable* valueCacheSingle;
-extern VgHashTable* valueCacheDouble;
+extern ULong numLazyLeaves;
+extern ULong numMaterializedLeaves;
+extern InternEntry* internTable;
+extern UWord numInternedValues;
+extern ULong numInternHits;
+extern ULong numInternMisses;
+extern ULong numInternFullMisses;
 
 typedef struct _Word256 {
   UWord bytes[4];
@@ -102,7 +206,23 @@ extern Word256 getBytes;
 
 extern int blockStateDirty;
 
+extern ShadowValue* deferredFrees[MAX_DEFERRED_FREES];
+extern UWord numDeferredFrees;
+extern ULong numDeferredFreesApplied;
+extern ULong numDeferredFreesRescued;
+
+extern ShadowValue** gcValues;
+extern UWord numGCValues;
+extern UWord gcValuesCapacity;
+extern UWord gcAllocsUntilCollect;
+extern UWord gcPending;
+extern ULong numCollections;
+extern ULong numCollectedValues;
+
 void initValueShadowState(void);
+void shadowThreadCreate(ThreadId parent, ThreadId child);
+void shadowThreadExit(ThreadId tid);
+void shadowThreadRun(ThreadId tid, ULong blocksDone);
 VG_REGPARM(2) void dynamicCleanup(int nentries, IRTemp* entries);
 VG_REGPARM(2) void dynamicPut(Int tsDest, ShadowTemp* st);
 VG_REGPARM(2) ShadowTemp* dynamicGet64(Int tsSrc,
@@ -117,6 +237,13 @@ VG_REGPARM(3) void setMemShadowTemp(Addr64 memDest, UWord size,
 VG_REGPARM(1) ShadowValue* getMemShadow(Addr64 memSrc);
 void removeMemShadow(Addr64 addr);
 void addMemShadow(Addr64 addr, ShadowValue* val);
+void clearMemShadowRange(Addr64 start, SizeT len);
+void discardMemShadowRange(Addr64 start, SizeT len);
+void copyMemShadowRange(Addr64 dest, Addr64 src, SizeT len);
+void dieMemStack(Addr start, SizeT len);
+void newMemStack(Addr start, SizeT len);
+void maybeEvictMemShadows(void);
+void printShadowMemStats(void);
 
 VG_REGPARM(1) void disownShadowTempNonNull(ShadowTemp* temp);
 VG_REGPARM(1) void disownShadowTemp(ShadowTemp* temp);
@@ -131,9 +258,18 @@ VG_REGPARM(1) void disownShadowTempDynamic(IRTemp idx);
 void disownShadowValue(ShadowValue* val);
 void ownShadowValue(ShadowValue* val);
 void freeShadowValue(ShadowValue* val);
+void deferFreeShadowValue(ShadowValue* val);
+void flushDeferredFrees(void);
+void trackShadowValue(ShadowValue* val);
+void collectShadowValues(void);
 ShadowValue* copyShadowValue(ShadowValue* val);
 ShadowValue* mkShadowValueBare(ValueType type);
+void mkShadowValuesBare(ValueType type, int count, ShadowValue** out);
 ShadowValue* mkShadowValue(ValueType type, double value);
+ShadowValue* mkLazyShadowValue(ValueType type, double value);
+void materializeLazyLeaf(ShadowValue* val);
+void materializeShadowTemp(ShadowTemp* temp);
+void uninternShadowValue(ShadowValue* val);
 VG_REGPARM(2) ShadowValue* mkShadowValue_wrapper(ValueType type, UWord value);
 
 VG_REGPARM(1) ShadowTemp* mkShadowTempOneDouble(UWord value);
@@ -146,9 +282,12 @@ ShadowValue* getTS(Int idx);
 VG_REGPARM(2) void printStoreValue(const char* dest_label, ShadowValue* val);
 void printStoreValueF(ShadowValue* val, const char* format, ...);
 
+inline Bool inPrimaryMap(Addr64 addr);
+inline UWord* getMemShadowSlot(Addr64 addr);
+inline ShadowValue* slotHalf(UWord slot, int half);
 inline ShadowValue* mkShadowValueBare_fast(ValueType type);
 inline ShadowValue* mkShadowValue_fast(ValueType type, double value);
-inline void freeShadowValue_fast(ShadowValue* val);
+inline void materializeShadowValue(ShadowValue* val);
 inline void freeShadowTemp_fast(ShadowTemp* temp);
 inline void disownNonNullShadowValue(ShadowValue* val);
 inline void ownNonNullShadowValue(ShadowValue* val);
@@ -156,16 +295,34 @@ inline void disownShadowTemp_fast(ShadowTemp* temp);
 
 __attribute__((always_inline))
 inline
-ShadowValue* mkShadowValueBare_fast(ValueType type){
-  ShadowValue* result;
-  if (stack_empty_fast(freedVals)){
-    result = newShadowValue(type);
+Bool inPrimaryMap(Addr64 addr){
+  return (addr & AUX_ADDR_MASK) == 0;
+}
+// Only valid for addresses in the primary map. The slot might be in
+// the empty secondary map, so don't write to it.
+__attribute__((always_inline))
+inline
+UWord* getMemShadowSlot(Addr64 addr){
+  return &(primaryMap[addr >> SM_BITS]->
+           slots[(addr & SM_MASK) / sizeof(double)]);
+}
+// Get the shadow value for the first (0) or second (1) four-byte
+// block in a slot.
+__attribute__((always_inline))
+inline
+ShadowValue* slotHalf(UWord slot, int half){
+  if (SLOT_IS_SPLIT(slot)){
+    return SLOT_SPLIT(slot)->halves[half];
+  } else if (half == 0){
+    return (ShadowValue*)slot;
   } else {
-    result = (void*)stack_pop_fast(freedVals);
-    result->type = type;
+    return NULL;
   }
-  result->ref_count = 1;
-  return result;
+}
+__attribute__((always_inline))
+inline
+ShadowValue* mkShadowValueBare_fast(ValueType type){
+  return newShadowValue(type);
 }
 __attribute__((always_inline))
 inline
@@ -174,10 +331,14 @@ ShadowValue* mkShadowValue_fast(ValueType type, double value){
   setReal_fast(result->real, value);
   return result;
 }
+// Call this before looking at the real or expression of a value
+// that might have come from client data.
 __attribute__((always_inline))
 inline
-void freeShadowValue_fast(ShadowValue* val){
-  stack_push_fast(freedVals, (void*)val);
+void materializeShadowValue(ShadowValue* val){
+  if (val != NULL && val->lazy){
+    materializeLazyLeaf(val);
+  }
 }
 __attribute__((always_inline))
 inline
@@ -187,14 +348,16 @@ void freeShadowTemp_fast(ShadowTemp* temp){
 __attribute__((always_inline))
 inline
 void disownNonNullShadowValue(ShadowValue* val){
+  if (shadow_gc == Gc_MarkSweep) return;
   val->ref_count--;
   if (val->ref_count == 0){
-    freeShadowValue(val);
+    deferFreeShadowValue(val);
   }
 }
 __attribute__((always_inline))
 inline
 void ownNonNullShadowValue(ShadowValue* val){
+  if (shadow_gc == Gc_MarkSweep) return;
   (val->ref_count)++;
 }
 __attribute__((always_inline))
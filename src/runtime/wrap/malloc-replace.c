@@ -0,0 +1,134 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie       malloc-replace.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "malloc-replace.h"
+#include "../value-shadowstate/value-shadowstate.h"
+
+#include "pub_tool_libcbase.h"
+#include "pub_tool_libcprint.h"
+#include "pub_tool_mallocfree.h"
+#include "pub_tool_replacemalloc.h"
+
+#include "../../options.h"
+
+// Maps the start of every live client block to its size.
+VgHashTable* heapBlocks;
+
+void initMallocReplacement(void){
+  heapBlocks = VG_(HT_construct)("heap blocks");
+}
+
+void* allocBlock(SizeT size, SizeT align, Bool zeroed){
+  void* p = VG_(cli_malloc)(align, size);
+  if (p == NULL){
+    return NULL;
+  }
+  if (zeroed){
+    VG_(memset)(p, 0, size);
+  }
+  HeapBlock* block = VG_(malloc)("heapBlock", sizeof(HeapBlock));
+  block->payload = (UWord)p;
+  block->size = size;
+  VG_(HT_add_node)(heapBlocks, block);
+  return p;
+}
+void freeBlock(void* p){
+  HeapBlock* block = VG_(HT_remove)(heapBlocks, (UWord)p);
+  if (block == NULL){
+    // Either NULL, or something we didn't allocate; either way, not
+    // our problem.
+    return;
+  }
+  if (print_allocs){
+    VG_(printf)("Client freed block %p of size %lu, "
+                "clearing its shadows\n", p, block->size);
+  }
+  clearMemShadowRange((Addr)p, block->size);
+  VG_(cli_free)(p);
+  VG_(free)(block);
+}
+
+void* hg_malloc(ThreadId tid, SizeT size){
+  return allocBlock(size, VG_(clo_alignment), False);
+}
+void* hg_builtin_new(ThreadId tid, SizeT size){
+  return allocBlock(size, VG_(clo_alignment), False);
+}
+void* hg_builtin_vec_new(ThreadId tid, SizeT size){
+  return allocBlock(size, VG_(clo_alignment), False);
+}
+void* hg_memalign(ThreadId tid, SizeT align, SizeT size){
+  return allocBlock(size, align, False);
+}
+void* hg_calloc(ThreadId tid, SizeT nmemb, SizeT size){
+  // Overflow check, the same way the other tools do it.
+  if (size != 0 && nmemb > ((SizeT)-1) / size){
+    return NULL;
+  }
+  return allocBlock(nmemb * size, VG_(clo_alignment), True);
+}
+void hg_free(ThreadId tid, void* p){
+  freeBlock(p);
+}
+void hg_builtin_delete(ThreadId tid, void* p){
+  freeBlock(p);
+}
+void hg_builtin_vec_delete(ThreadId tid, void* p){
+  freeBlock(p);
+}
+void* hg_realloc(ThreadId tid, void* p, SizeT new_size){
+  if (p == NULL){
+    return hg_malloc(tid, new_size);
+  }
+  if (new_size == 0){
+    freeBlock(p);
+    return NULL;
+  }
+  HeapBlock* block = VG_(HT_lookup)(heapBlocks, (UWord)p);
+  if (block == NULL){
+    return NULL;
+  }
+  void* newP = allocBlock(new_size, VG_(clo_alignment), False);
+  if (newP == NULL){
+    return NULL;
+  }
+  SizeT copySize = block->size < new_size ? block->size : new_size;
+  VG_(memcpy)(newP, p, copySize);
+  // The values move with the data.
+  copyMemShadowRange((Addr)newP, (Addr)p, copySize);
+  freeBlock(p);
+  return newP;
+}
+SizeT hg_malloc_usable_size(ThreadId tid, void* p){
+  HeapBlock* block = VG_(HT_lookup)(heapBlocks, (UWord)p);
+  if (block == NULL){
+    return 0;
+  }
+  return block->size;
+}
@@ -0,0 +1,61 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie       malloc-replace.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+// We replace the client's malloc and friends so that we know when
+// heap blocks die, and can drop any shadow values that were living in
+// them. Otherwise, shadows written into freed memory stick around
+// (along with their reals and expressions) until something else
+// happens to store to the same address.
+
+#ifndef _MALLOC_REPLACE_H
+#define _MALLOC_REPLACE_H
+
+#include "pub_tool_basics.h"
+#include "pub_tool_hashtable.h"
+
+typedef struct _heapBlock {
+  struct _heapBlock* next;
+  UWord payload;
+  SizeT size;
+} HeapBlock;
+
+void initMallocReplacement(void);
+
+void* hg_malloc(ThreadId tid, SizeT size);
+void* hg_builtin_new(ThreadId tid, SizeT size);
+void* hg_builtin_vec_new(ThreadId tid, SizeT size);
+void* hg_memalign(ThreadId tid, SizeT align, SizeT size);
+void* hg_calloc(ThreadId tid, SizeT nmemb, SizeT size);
+void hg_free(ThreadId tid, void* p);
+void hg_builtin_delete(ThreadId tid, void* p);
+void hg_builtin_vec_delete(ThreadId tid, void* p);
+void* hg_realloc(ThreadId tid, void* p, SizeT new_size);
+SizeT hg_malloc_usable_size(ThreadId tid, void* p);
+
+#endif
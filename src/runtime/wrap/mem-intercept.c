@@ -0,0 +1,59 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie        mem-intercept.c ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#include "mem-intercept.h"
+#include "../value-shadowstate/value-shadowstate.h"
+
+#include "pub_tool_aspacemgr.h"
+#include "pub_tool_libcbase.h"
+#include "pub_tool_vki.h"
+
+Bool interceptMemmove(Addr dest, Addr src, SizeT len){
+  if (len == 0){
+    return True;
+  }
+  if (!VG_(am_is_valid_for_client)(src, len, VKI_PROT_READ) ||
+      !VG_(am_is_valid_for_client)(dest, len, VKI_PROT_WRITE)){
+    return False;
+  }
+  VG_(memmove)((void*)dest, (void*)src, len);
+  copyMemShadowRange(dest, src, len);
+  return True;
+}
+Bool interceptMemset(Addr dest, Int c, SizeT len){
+  if (len == 0){
+    return True;
+  }
+  if (!VG_(am_is_valid_for_client)(dest, len, VKI_PROT_WRITE)){
+    return False;
+  }
+  VG_(memset)((void*)dest, c, len);
+  clearMemShadowRange(dest, len);
+  return True;
+}
@@ -0,0 +1,43 @@
+/*--------------------------------------------------------------------*/
+/*--- Herbgrind: a valgrind tool for Herbie        mem-intercept.h ---*/
+/*--------------------------------------------------------------------*/
+
+/*
+   This file is part of Herbgrind, a valgrind tool for diagnosing
+   floating point accuracy problems in binary programs and extracting
+   problematic expressions.
+
+   Copyright (C) 2016-2017 Alex Sanchez-Stern
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 3 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+   02111-1307, USA.
+
+   The GNU General Public License is contained in the file COPYING.
+*/
+
+#ifndef _MEM_INTERCEPT_H
+#define _MEM_INTERCEPT_H
+
+#include "pub_tool_basics.h"
+
+// These do the actual work of the client's memcpy, memmove, memset,
+// and bzero (see helper/memwrap.c), moving the shadow values along
+// with the bytes. They return False if the memory isn't accessible to
+// the client, in which case the wrapper falls back to doing the copy
+// itself, so that the client faults the way it normally would.
+Bool interceptMemmove(Addr dest, Addr src, SizeT len);
+Bool interceptMemset(Addr dest, Int c, SizeT len);
+
+#endif